@@ -0,0 +1,685 @@
+// blocksim.cc
+//	Basic-block threaded-code engine for the MIPS simulator.
+//
+//	Each handler below is a copy of one case of the switch in
+//	Machine::Execute, followed by the same delayed-load and program
+//	counter update.  Opcodes without a handler of their own (and
+//	those whose simulation has quirks we must reproduce exactly) go
+//	through ExecGeneric, which simply calls Machine::Execute.
+//
+//	Since every handler updates PCReg/NextPCReg just like the
+//	interpreter does, branch delay slots and delayed loads behave
+//	exactly as in Machine::OneInstruction: a block holds a branch
+//	together with its delay slot, and is only entered when the
+//	machine is not in the middle of a delay slot.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+#include "machine.h"
+#include "mipssim.h"
+#include "blocksim.h"
+#include "system.h"
+
+static OpHandler opHandlers[MaxOpcode + 1];	// handler for each opcode
+static bool handlersReady = FALSE;
+
+//----------------------------------------------------------------------
+// Retire
+// 	Finish an instruction: apply the pending delayed load, queue up
+//	the new one (if any) and advance the program counters.
+//----------------------------------------------------------------------
+
+static inline void
+Retire(Machine *m, int nextLoadReg, int nextLoadValue, int pcAfter)
+{
+    int *registers = m->registers;
+
+    registers[registers[LoadReg]] = registers[LoadValueReg];
+    registers[LoadReg] = nextLoadReg;
+    registers[LoadValueReg] = nextLoadValue;
+    registers[0] = 0;
+    registers[PrevPCReg] = registers[PCReg];
+    registers[PCReg] = registers[NextPCReg];
+    registers[NextPCReg] = pcAfter;
+}
+
+//----------------------------------------------------------------------
+// Instruction handlers
+//----------------------------------------------------------------------
+
+static bool
+ExecGeneric(Machine *m, Instruction *instr)
+{
+    return m->Execute(instr);
+}
+
+static bool
+ExecAddiu(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[instr->rt] = r[instr->rs] + instr->extra;
+    Retire(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecAddu(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[instr->rd] = r[instr->rs] + r[instr->rt];
+    Retire(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecSubu(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[instr->rd] = r[instr->rs] - r[instr->rt];
+    Retire(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecAnd(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[instr->rd] = r[instr->rs] & r[instr->rt];
+    Retire(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecAndi(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[instr->rt] = r[instr->rs] & (instr->extra & 0xffff);
+    Retire(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecOri(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[instr->rt] = r[instr->rs] | (instr->extra & 0xffff);
+    Retire(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecXor(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[instr->rd] = r[instr->rs] ^ r[instr->rt];
+    Retire(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecXori(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[instr->rt] = r[instr->rs] ^ (instr->extra & 0xffff);
+    Retire(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecNor(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[instr->rd] = ~(r[instr->rs] | r[instr->rt]);
+    Retire(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecLui(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[instr->rt] = instr->extra << 16;
+    Retire(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecSll(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[instr->rd] = r[instr->rt] << instr->extra;
+    Retire(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecSra(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[instr->rd] = r[instr->rt] >> instr->extra;
+    Retire(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecSlt(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[instr->rd] = (r[instr->rs] < r[instr->rt]) ? 1 : 0;
+    Retire(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecSlti(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[instr->rt] = (r[instr->rs] < instr->extra) ? 1 : 0;
+    Retire(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecSltiu(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[instr->rt] = ((unsigned int) r[instr->rs] < (unsigned int) instr->extra)
+                   ? 1 : 0;
+    Retire(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecSltu(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[instr->rd] = ((unsigned int) r[instr->rs] < (unsigned int) r[instr->rt])
+                   ? 1 : 0;
+    Retire(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecMfhi(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[instr->rd] = r[HiReg];
+    Retire(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecMflo(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    r[instr->rd] = r[LoReg];
+    Retire(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecBeq(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+    int pcAfter = r[NextPCReg] + 4;
+
+    if (r[instr->rs] == r[instr->rt])
+        pcAfter = r[NextPCReg] + IndexToAddr(instr->extra);
+    Retire(m, 0, 0, pcAfter);
+    return TRUE;
+}
+
+static bool
+ExecBne(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+    int pcAfter = r[NextPCReg] + 4;
+
+    if (r[instr->rs] != r[instr->rt])
+        pcAfter = r[NextPCReg] + IndexToAddr(instr->extra);
+    Retire(m, 0, 0, pcAfter);
+    return TRUE;
+}
+
+static bool
+ExecBlez(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+    int pcAfter = r[NextPCReg] + 4;
+
+    if (r[instr->rs] <= 0)
+        pcAfter = r[NextPCReg] + IndexToAddr(instr->extra);
+    Retire(m, 0, 0, pcAfter);
+    return TRUE;
+}
+
+static bool
+ExecBgtz(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+    int pcAfter = r[NextPCReg] + 4;
+
+    if (r[instr->rs] > 0)
+        pcAfter = r[NextPCReg] + IndexToAddr(instr->extra);
+    Retire(m, 0, 0, pcAfter);
+    return TRUE;
+}
+
+static bool
+ExecJ(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+    int pcAfter = r[NextPCReg] + 4;
+
+    Retire(m, 0, 0, (pcAfter & 0xf0000000) | IndexToAddr(instr->extra));
+    return TRUE;
+}
+
+static bool
+ExecJal(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+    int pcAfter = r[NextPCReg] + 4;
+
+    r[R31] = r[NextPCReg] + 4;
+    Retire(m, 0, 0, (pcAfter & 0xf0000000) | IndexToAddr(instr->extra));
+    return TRUE;
+}
+
+static bool
+ExecJr(Machine *m, Instruction *instr)
+{
+    Retire(m, 0, 0, m->registers[instr->rs]);
+    return TRUE;
+}
+
+static bool
+ExecLw(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+    int addr = r[instr->rs] + instr->extra;
+    int value;
+
+    if (addr & 0x3) {
+        m->RaiseException(AddressErrorException, addr);
+        return FALSE;
+    }
+    if (!m->ReadMem(addr, 4, &value))
+        return FALSE;
+    Retire(m, instr->rt, value, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecLbu(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+    int value;
+
+    if (!m->ReadMem(r[instr->rs] + instr->extra, 1, &value))
+        return FALSE;
+    Retire(m, instr->rt, value & 0xff, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecLb(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+    int value;
+
+    if (!m->ReadMem(r[instr->rs] + instr->extra, 1, &value))
+        return FALSE;
+    if (value & 0x80)
+        value |= 0xffffff00;
+    else
+        value &= 0xff;
+    Retire(m, instr->rt, value, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecSw(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    if (!m->WriteMem((unsigned) (r[instr->rs] + instr->extra), 4, r[instr->rt]))
+        return FALSE;
+    Retire(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+static bool
+ExecSb(Machine *m, Instruction *instr)
+{
+    int *r = m->registers;
+
+    if (!m->WriteMem((unsigned) (r[instr->rs] + instr->extra), 1, r[instr->rt]))
+        return FALSE;
+    Retire(m, 0, 0, r[NextPCReg] + 4);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Fused handlers
+// 	Each runs a whole idiom by calling the handlers of its parts in
+//	order, so the result is exact by construction; what we save is
+//	the dispatch and clock bookkeeping in between.  Only the last
+//	instruction of a fused sequence can trap.
+//----------------------------------------------------------------------
+
+#define FUSED_PAIR(name, first, second)					\
+static bool								\
+name(Machine *m, Instruction *instr)					\
+{									\
+    (void) first(m, instr);						\
+    return second(m, instr + 1);					\
+}
+
+FUSED_PAIR(FusedLuiOri, ExecLui, ExecOri)
+FUSED_PAIR(FusedLuiAddiu, ExecLui, ExecAddiu)
+FUSED_PAIR(FusedSltBeq, ExecSlt, ExecBeq)
+FUSED_PAIR(FusedSltBne, ExecSlt, ExecBne)
+FUSED_PAIR(FusedSltuBeq, ExecSltu, ExecBeq)
+FUSED_PAIR(FusedSltuBne, ExecSltu, ExecBne)
+FUSED_PAIR(FusedSltiBeq, ExecSlti, ExecBeq)
+FUSED_PAIR(FusedSltiBne, ExecSlti, ExecBne)
+FUSED_PAIR(FusedSltiuBeq, ExecSltiu, ExecBeq)
+FUSED_PAIR(FusedSltiuBne, ExecSltiu, ExecBne)
+
+static bool
+FusedLuiLw(Machine *m, Instruction *instr)
+{
+    (void) ExecLui(m, instr);
+    interrupt->AdvanceUserTicks(1);		// the load may trap
+    return ExecLw(m, instr + 1);
+}
+
+static bool
+FusedLuiAddiuLw(Machine *m, Instruction *instr)
+{
+    (void) ExecLui(m, instr);
+    (void) ExecAddiu(m, instr + 1);
+    interrupt->AdvanceUserTicks(2);		// the load may trap
+    return ExecLw(m, instr + 2);
+}
+
+//----------------------------------------------------------------------
+// InitHandlers
+// 	Fill in the opcode -> handler table.  Anything not listed here
+//	(overflow-checking arithmetic, multiply/divide, unaligned and
+//	halfword memory ops, the linking conditional branches, syscall,
+//	and OR and SRL, whose interpreter versions we must match bit for
+//	bit) is run by Machine::Execute.
+//----------------------------------------------------------------------
+
+static void
+InitHandlers()
+{
+    for (int i = 0; i <= MaxOpcode; i++)
+        opHandlers[i] = ExecGeneric;
+
+    opHandlers[OP_ADDIU] = ExecAddiu;
+    opHandlers[OP_ADDU] = ExecAddu;
+    opHandlers[OP_SUBU] = ExecSubu;
+    opHandlers[OP_AND] = ExecAnd;
+    opHandlers[OP_ANDI] = ExecAndi;
+    opHandlers[OP_ORI] = ExecOri;
+    opHandlers[OP_XOR] = ExecXor;
+    opHandlers[OP_XORI] = ExecXori;
+    opHandlers[OP_NOR] = ExecNor;
+    opHandlers[OP_LUI] = ExecLui;
+    opHandlers[OP_SLL] = ExecSll;
+    opHandlers[OP_SRA] = ExecSra;
+    opHandlers[OP_SLT] = ExecSlt;
+    opHandlers[OP_SLTI] = ExecSlti;
+    opHandlers[OP_SLTIU] = ExecSltiu;
+    opHandlers[OP_SLTU] = ExecSltu;
+    opHandlers[OP_MFHI] = ExecMfhi;
+    opHandlers[OP_MFLO] = ExecMflo;
+    opHandlers[OP_BEQ] = ExecBeq;
+    opHandlers[OP_BNE] = ExecBne;
+    opHandlers[OP_BLEZ] = ExecBlez;
+    opHandlers[OP_BGTZ] = ExecBgtz;
+    opHandlers[OP_J] = ExecJ;
+    opHandlers[OP_JAL] = ExecJal;
+    opHandlers[OP_JR] = ExecJr;
+    opHandlers[OP_LW] = ExecLw;
+    opHandlers[OP_LB] = ExecLb;
+    opHandlers[OP_LBU] = ExecLbu;
+    opHandlers[OP_SW] = ExecSw;
+    opHandlers[OP_SB] = ExecSb;
+    handlersReady = TRUE;
+}
+
+//----------------------------------------------------------------------
+// IsControlTransfer
+// 	TRUE if "opCode" may change the flow of control, so that the
+//	instruction after it is a branch delay slot.
+//----------------------------------------------------------------------
+
+static bool
+IsControlTransfer(int opCode)
+{
+    switch (opCode) {
+    case OP_BEQ:
+    case OP_BNE:
+    case OP_BLEZ:
+    case OP_BGTZ:
+    case OP_BLTZ:
+    case OP_BGEZ:
+    case OP_BLTZAL:
+    case OP_BGEZAL:
+    case OP_J:
+    case OP_JAL:
+    case OP_JR:
+    case OP_JALR:
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// Fuse
+// 	Fill in "op" for the instruction(s) starting at "instr", fusing
+//	it with the ones after it if they form one of the idioms we know.
+//	"left" is how many instructions of the block remain, so a fused
+//	sequence never runs past the end of the block -- in particular,
+//	never past a branch delay slot.
+//----------------------------------------------------------------------
+
+static void
+Fuse(ThreadedOp *op, Instruction *instr, int left)
+{
+    int first = instr[0].opCode;
+    int second = (left >= 2) ? instr[1].opCode : OP_RES;
+    int third = (left >= 3) ? instr[2].opCode : OP_RES;
+
+    op->instr = instr;
+    op->single = opHandlers[first];
+    op->handler = op->single;
+    op->length = 1;
+    op->ticks = 1;
+
+    if (first == OP_LUI) {
+        if (second == OP_ADDIU && third == OP_LW) {
+            op->handler = FusedLuiAddiuLw;
+            op->length = 3;
+        } else if (second == OP_ADDIU) {
+            op->handler = FusedLuiAddiu;
+            op->length = op->ticks = 2;
+        } else if (second == OP_ORI) {
+            op->handler = FusedLuiOri;
+            op->length = op->ticks = 2;
+        } else if (second == OP_LW) {
+            op->handler = FusedLuiLw;
+            op->length = 2;
+        }
+    } else if (second == OP_BEQ || second == OP_BNE) {
+        bool bne = (second == OP_BNE);
+
+        switch (first) {
+        case OP_SLT:
+            op->handler = bne ? FusedSltBne : FusedSltBeq;
+            break;
+        case OP_SLTU:
+            op->handler = bne ? FusedSltuBne : FusedSltuBeq;
+            break;
+        case OP_SLTI:
+            op->handler = bne ? FusedSltiBne : FusedSltiBeq;
+            break;
+        case OP_SLTIU:
+            op->handler = bne ? FusedSltiuBne : FusedSltiuBeq;
+            break;
+        }
+        if (op->handler != op->single)
+            op->length = op->ticks = 2;
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::BuildBlock
+// 	Translate the straight-line code starting at "physAddr" into a
+//	threaded-code block, and remember it.  The block stops after the
+//	delay slot of the first branch or jump, after a syscall or an
+//	illegal instruction, or at the end of the page.
+//----------------------------------------------------------------------
+
+BasicBlock *
+Machine::BuildBlock(int physAddr)
+{
+    BasicBlock *block = new BasicBlock;
+    int pageEnd = (physAddr / PageSize + 1) * PageSize;
+    bool inDelaySlot = FALSE;
+    int count = 0;
+
+    if (!handlersReady)
+        InitHandlers();
+
+    // First find (and decode) the instructions in the block...
+    for (int addr = physAddr; addr < pageEnd; addr += 4) {
+        Instruction *instr = FetchDecoded(addr);
+
+        count++;
+        if (inDelaySlot)
+            break;
+        if (instr->opCode == OP_SYSCALL || instr->opCode == OP_RES ||
+                instr->opCode == OP_UNIMP)
+            break;
+        inDelaySlot = IsControlTransfer(instr->opCode);
+    }
+
+    // ... then turn them into handlers, fusing where we can
+    Instruction *first = &decodedInstrs[physAddr / 4];
+    block->length = 0;
+    for (int i = 0; i < count; i += block->ops[block->length++].length)
+        Fuse(&block->ops[block->length], first + i, count - i);
+
+    blockCache[physAddr / 4] = block;
+    blocksInFrame[physAddr / PageSize]++;
+    return block;
+}
+
+//----------------------------------------------------------------------
+// Machine::DropBlocks
+// 	Discard every block that starts in physical page "frame", because
+//	the code in it has changed.  Bumping blockGeneration tells a
+//	RunBlock that may be in the middle of one of them to stop.
+//----------------------------------------------------------------------
+
+void
+Machine::DropBlocks(int frame)
+{
+    int first = frame * MaxBlockLength;
+
+    for (int i = first; i < first + MaxBlockLength; i++) {
+        if (blockCache[i] != NULL) {
+            delete blockCache[i];
+            blockCache[i] = NULL;
+        }
+    }
+    blocksInFrame[frame] = 0;
+    blockGeneration++;
+}
+
+//----------------------------------------------------------------------
+// Machine::RunBlock
+// 	Run the basic block starting at the current PC, building it first
+//	if need be.  The caller guarantees that "budget" instructions can
+//	run before any interrupt may be due, so we only run that many, and
+//	just advance the clock after each one -- except after a trap,
+//	since the kernel may have scheduled an interrupt or used up time.
+//	A fused slot that doesn't fit in what is left of the budget is
+//	cut short after its first instruction.
+//
+//	We stop early if an instruction traps to the kernel (the kernel
+//	may have switched threads, changed the page table, or freed this
+//	very block), or if the block was invalidated by a store.  Either
+//	way the machine state is exactly what the interpreter would have
+//	left, so the next instruction simply starts a new block.
+//----------------------------------------------------------------------
+
+void
+Machine::RunBlock(int budget)
+{
+    int physAddr;
+    ExceptionType exception;
+
+    exception = TranslateFetch(registers[PCReg], &physAddr);
+    if (exception != NoException) {
+        RaiseException(exception, registers[PCReg]);
+        interrupt->OneTick();
+        return;
+    }
+
+    BasicBlock *block = blockCache[physAddr / 4];
+    if (block == NULL)
+        block = BuildBlock(physAddr);
+
+    int generation = blockGeneration;
+    for (int i = 0; i < block->length && budget > 0; i++) {
+        ThreadedOp *op = &block->ops[i];
+        int ticks = op->ticks;		// a store may free the block (see
+        int length = op->length;	// DropBlocks), so don't touch "op"
+					// after running it
+
+        if (length > budget) {
+            if ((*op->single)(this, op->instr))
+                interrupt->AdvanceUserTicks(1);
+            else
+                interrupt->OneTick();
+            break;
+        }
+        if (!(*op->handler)(this, op->instr)) {
+            interrupt->OneTick();
+            break;
+        }
+        interrupt->AdvanceUserTicks(ticks);
+        budget -= length;
+        if (generation != blockGeneration)
+            break;			// before "block" is looked at again
+    }
+}
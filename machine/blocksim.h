@@ -0,0 +1,64 @@
+// blocksim.h
+//	Data structures for the basic-block ("threaded code") engine.
+//
+//	Instead of fetching, decoding and dispatching one instruction at
+//	a time through the big switch in Machine::Execute, user code is
+//	cut into basic blocks -- straight-line runs of instructions that
+//	end at a branch (plus its delay slot), a syscall, or the end of
+//	a page.  Each block is turned into an array of pointers to small
+//	per-opcode handler routines, which Machine::RunBlock calls one
+//	after the other.  A block is only run as far as the next pending
+//	interrupt allows, so interrupts still arrive between the same two
+//	instructions as with the interpreter.
+//
+//	Blocks are keyed by the physical address of their first
+//	instruction, and are thrown away whenever the frame they live in
+//	is written or reloaded (see Machine::InvalidateDecoded).
+//
+//	When a block is built, a few instruction sequences the compiler
+//	emits all the time (lui+ori and lui+addiu constants, lui+addiu+lw
+//	and lui+lw loads from a global, slt+bne style compare-and-branch)
+//	are "fused": one slot of the block runs the whole sequence.  The
+//	fused handlers are made out of the single-instruction ones, so
+//	the machine state after each instruction, and the time charged
+//	for it, are the same as if they had been run one at a time.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef BLOCKSIM_H
+#define BLOCKSIM_H
+
+#include "copyright.h"
+#include "machine.h"
+
+#define MaxBlockLength	(PageSize / 4)	// a block never crosses a page
+
+// A handler carries out one (already decoded) instruction, exactly as
+// Machine::Execute would, and returns FALSE if it trapped to the kernel.
+typedef bool (*OpHandler)(Machine *machine, Instruction *instr);
+
+// One slot of a threaded-code block.  A fused slot covers "length"
+// consecutive instructions, whose decoded forms follow "instr" in
+// Machine's cache.  A handler that may trap in a later instruction
+// first advances the clock for the ones before it; RunBlock charges
+// the remaining "ticks" once the handler returns.
+class ThreadedOp {
+  public:
+    OpHandler handler;		// routine that carries out the instruction(s)
+    OpHandler single;		// routine for just the first of them
+    Instruction *instr;		// decoded form of the first (in Machine's
+    				// cache)
+    int length;			// number of instructions covered
+    int ticks;			// user ticks left to charge on success
+};
+
+// A basic block, ready to run.
+class BasicBlock {
+  public:
+    int length;				// number of valid entries in "ops"
+    ThreadedOp ops[MaxBlockLength];	// handlers, in program order
+};
+
+#endif // BLOCKSIM_H
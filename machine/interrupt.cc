@@ -65,6 +65,9 @@ Interrupt::Interrupt()
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
+    nextDue = NoneDue;
+    skippedChecks = 0;
+    tracing = DebugIsEnabled('i');
 }
 
 //----------------------------------------------------------------------
@@ -144,6 +147,11 @@ Interrupt::Enable()
 // 	Advance simulated time and check if there are any pending
 //	interrupts to be called.
 //
+//	If nothing can be due yet, we don't bother: looking at the
+//	pending list would only disable and re-enable interrupts, and
+//	take the first interrupt off the list and put it back.  We just
+//	remember that we owe the list that last step (see CatchUp).
+//
 //	Two things can cause OneTick to be called:
 //		interrupts are re-enabled
 //		a user instruction is executed
@@ -151,8 +159,6 @@ Interrupt::Enable()
 void
 Interrupt::OneTick()
 {
-    MachineStatus old = status;
-
 // advance simulated time
     if (status == SystemMode) {
         stats->totalTicks += SystemTick;
@@ -163,6 +169,72 @@ Interrupt::OneTick()
     }
     DEBUG('i', "\n== Tick %d ==\n", stats->totalTicks);
 
+    if (!tracing && stats->totalTicks < nextDue) {
+        skippedChecks++;
+        return;
+    }
+    FireDueInterrupts();
+}
+
+//----------------------------------------------------------------------
+// Interrupt::UserTicksUntilDue
+// 	Return how many user instructions can be executed, one after the
+//	other, before an interrupt may become due.  The simulator may
+//	account for those with AdvanceUserTicks instead of OneTick.
+//
+//	Of course, this only holds as long as nobody schedules another
+//	interrupt, so the simulator has to ask again after any trap to
+//	the kernel.
+//----------------------------------------------------------------------
+int
+Interrupt::UserTicksUntilDue()
+{
+    if (tracing || nextDue <= stats->totalTicks)
+        return 0;
+    return (nextDue - 1 - stats->totalTicks) / UserTick;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::AdvanceUserTicks
+// 	Advance simulated time by "count" user instructions, which the
+//	caller knows (from UserTicksUntilDue) will not make any interrupt
+//	due.  Same effect as calling OneTick "count" times in user mode.
+//----------------------------------------------------------------------
+void
+Interrupt::AdvanceUserTicks(int count)
+{
+    stats->totalTicks += count * UserTick;
+    stats->userTicks += count * UserTick;
+    skippedChecks += count;
+    ASSERT(stats->totalTicks < nextDue);
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Delay
+// 	Advance simulated time by "ticks" of kernel time, spent waiting on
+//	a device that is simulated synchronously (the disk under
+//	FILESYS_STUB).  Nothing is fired here, since the kernel may be in
+//	the middle of something; whatever became due fires at the next
+//	tick, like an interrupt that arrives while they are disabled.
+//----------------------------------------------------------------------
+void
+Interrupt::Delay(int ticks)
+{
+    stats->totalTicks += ticks;
+    stats->systemTicks += ticks;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::FireDueInterrupts
+// 	Invoke the handlers of any interrupts whose time has come, and
+//	do the context switch a handler asked for, if any.  Called each
+//	time simulated time has been advanced.
+//----------------------------------------------------------------------
+void
+Interrupt::FireDueInterrupts()
+{
+    MachineStatus old = status;
+
 // check any pending interrupts are now ready to fire
     ChangeLevel(IntOn, IntOff);		// first, turn off interrupts
     // (interrupt handlers run with
@@ -245,7 +317,8 @@ Interrupt::Halt()
 {
     //printf("Machine halting!\n\n");
     DEBUG('i',"Machine halting!\n\n");
-    //stats->Print();
+    if (printStats)
+	stats->Print();
     Cleanup();     // Never returns.
 }
 
@@ -275,7 +348,68 @@ Interrupt::Schedule(VoidFunctionPtr handler, int arg, int fromNow, IntType type)
           intTypeNames[type], when);
     ASSERT(fromNow > 0);
 
+    CatchUp();
     pending->SortedInsert(toOccur, when);
+    UpdateNextDue();
+}
+
+//----------------------------------------------------------------------
+// Interrupt::UpdateNextDue
+// 	Remember when the first pending interrupt is due.  Called
+//	whenever "pending" changes.
+//----------------------------------------------------------------------
+void
+Interrupt::UpdateNextDue()
+{
+    PendingInterrupt *first = (PendingInterrupt *)pending->GetTop();
+
+    nextDue = (first == NULL) ? NoneDue : first->when;
+}
+
+//----------------------------------------------------------------------
+// CountFirstGroup
+// 	Count the pending interrupts due at the same time as the first
+//	one.  Helper for CatchUp, called through List::Mapcar.
+//----------------------------------------------------------------------
+
+static int groupWhen, groupSize;
+
+static void
+CountFirstGroup(int arg)
+{
+    PendingInterrupt *pend = (PendingInterrupt *)arg;
+
+    if (pend->when == groupWhen)
+        groupSize++;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::CatchUp
+// 	Each check that OneTick skipped would have taken the first
+//	pending interrupt off the list and put it back behind any others
+//	due at the same time -- that is, rotated that group by one.  Do
+//	those rotations now, so that interrupts due at the same time fire
+//	in exactly the order they used to.
+//
+//	Must be called before anybody looks at or changes "pending".
+//----------------------------------------------------------------------
+void
+Interrupt::CatchUp()
+{
+    int when;
+
+    if (skippedChecks == 0)
+        return;
+    if (!pending->IsEmpty()) {
+        groupWhen = nextDue;
+        groupSize = 0;
+        pending->Mapcar(CountFirstGroup);
+        for (int i = skippedChecks % groupSize; i > 0; i--) {
+            void *first = pending->SortedRemove(&when);
+            pending->SortedInsert(first, when);
+        }
+    }
+    skippedChecks = 0;
 }
 
 //----------------------------------------------------------------------
@@ -299,6 +433,7 @@ Interrupt::CheckIfDue(bool advanceClock)
 
     ASSERT(level == IntOff);		// interrupts need to be disabled,
     // to invoke an interrupt handler
+    CatchUp();
     if (DebugIsEnabled('i'))
         DumpState();
     PendingInterrupt *toOccur =
@@ -306,12 +441,14 @@ Interrupt::CheckIfDue(bool advanceClock)
 
     if (toOccur == NULL)		// no pending interrupts
         return FALSE;
+    UpdateNextDue();
 
     if (advanceClock && when > stats->totalTicks) {	// advance the clock
         stats->idleTicks += (when - stats->totalTicks);
         stats->totalTicks = when;
     } else if (when > stats->totalTicks) {	// not time yet, put it back
         pending->SortedInsert(toOccur, when);
+        UpdateNextDue();
         return FALSE;
     }
 
@@ -319,6 +456,7 @@ Interrupt::CheckIfDue(bool advanceClock)
     if ((status == IdleMode) && (toOccur->type == TimerInt)
             && pending->IsEmpty()) {
         pending->SortedInsert(toOccur, when);
+        UpdateNextDue();
         return FALSE;
     }
 
@@ -363,6 +501,7 @@ PrintPending(int arg)
 void
 Interrupt::DumpState()
 {
+    CatchUp();
     printf("Time: %d, interrupts %s\n", stats->totalTicks,
            intLevelNames[level]);
     printf("Pending interrupts:\n");
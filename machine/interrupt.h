@@ -46,6 +46,9 @@ enum IntStatus { IntOff, IntOn };
 // is empty (IdleMode).
 enum MachineStatus {IdleMode, SystemMode, UserMode};
 
+// The "next due" time when no interrupt is pending at all
+#define NoneDue		0x7fffffff
+
 // IntType records which hardware device generated an interrupt.
 // In Nachos, we support a hardware timer device, a disk, a console
 // display and keyboard, and a network.
@@ -118,6 +121,13 @@ public:
     // by the hardware device simulators.
 
     void OneTick();       		// Advance simulated time
+    int UserTicksUntilDue();		// How many user instructions can
+    // run before an interrupt may be due
+    void AdvanceUserTicks(int count);	// Advance simulated time by "count"
+    // user instructions, without checking
+    // for interrupts
+    void Delay(int ticks);		// Advance simulated time while the
+    // kernel waits on a synchronous device
 
 private:
     IntStatus level;		// are interrupts enabled or disabled?
@@ -127,11 +137,21 @@ private:
     bool yieldOnReturn; 	// TRUE if we are to context switch
     // on return from the interrupt handler
     MachineStatus status;	// idle, kernel mode, user mode
+    int nextDue;		// when the first pending interrupt is
+    // due (NoneDue if there is none)
+    int skippedChecks;		// number of times OneTick left out
+    // CheckIfDue, because nothing was due
+    bool tracing;		// TRUE if 'i' debugging is on; we then
+    // check for interrupts on every tick
 
     // these functions are internal to the interrupt simulation code
 
     bool CheckIfDue(bool advanceClock); // Check if an interrupt is supposed
     // to occur now
+    void FireDueInterrupts();		// Run every handler that is due
+    void UpdateNextDue();		// Recompute nextDue from "pending"
+    void CatchUp();			// Bring "pending" to the state the
+    // skipped checks would have left it in
 
     void ChangeLevel(IntStatus old, 	// SetLevel, without advancing the
                      IntStatus now);  		// simulated time
@@ -10,6 +10,7 @@
 #include "copyright.h"
 #include "machine.h"
 #include "system.h"
+#include "blocksim.h"
 
 // Textual names of the exceptions that can be generated by user program
 // execution, for debugging.
@@ -50,9 +51,15 @@ void CheckEndian()
 //
 //	"debug" -- if TRUE, drop into the debugger after each user instruction
 //		is executed.
+//	"blocks" -- if TRUE, run user code with the basic-block engine
+//		(blocksim.cc) rather than the instruction-at-a-time
+//		interpreter.
+//	"tlbEntries" -- if not 0, translate through a TLB of that many
+//		entries, loaded by the kernel, instead of a page table
+//		(USE_TLB makes that TLBSize by default).
 //----------------------------------------------------------------------
 
-Machine::Machine(bool debug)
+Machine::Machine(bool debug, bool blocks, int tlbEntries)
 {
     int i;
 
@@ -61,15 +68,35 @@ Machine::Machine(bool debug)
     mainMemory = new char[MemorySize];
     for (i = 0; i < MemorySize; i++)
       	mainMemory[i] = 0;
+    decodedInstrs = new Instruction[NumMemWords];
+    decodedValid = new bool[NumMemWords];
+    for (i = 0; i < NumMemWords; i++)
+	decodedValid[i] = FALSE;
+    blockCache = new BasicBlock *[NumMemWords];
+    for (i = 0; i < NumMemWords; i++)
+	blockCache[i] = NULL;
+    blocksInFrame = new int[NumPhysPages];
+    for (i = 0; i < NumPhysPages; i++)
+	blocksInFrame[i] = 0;
+    blockGeneration = 0;
+    profile = NULL;
+    userTrap = FALSE;
+    useBlocks = blocks;
+    FlushSoftTLB();
 #ifdef USE_TLB
-    tlb = new TranslationEntry[TLBSize];
-    for (i = 0; i < TLBSize; i++)
-	tlb[i].valid = FALSE;
-    pageTable = NULL;
-#else	// use linear page table
-    tlb = NULL;
-    pageTable = NULL;
+    if (tlbEntries == 0)
+	tlbEntries = TLBSize;
 #endif
+    if (tlbEntries > 0) {
+	tlb = new TLBEntry[tlbEntries];
+	for (i = 0; i < tlbEntries; i++)
+	    tlb[i].valid = FALSE;
+    } else			// use linear page table
+	tlb = NULL;
+    tlbSize = tlbEntries;
+    currentASID = 0;
+    pageTable = NULL;
+    pageDirectory = NULL;
 
     singleStep = debug;
     CheckEndian();
@@ -83,6 +110,13 @@ Machine::Machine(bool debug)
 Machine::~Machine()
 {
     delete [] mainMemory;
+    delete [] decodedInstrs;
+    delete [] decodedValid;
+    for (int i = 0; i < NumPhysPages; i++)
+        if (blocksInFrame[i] > 0)
+            DropBlocks(i);
+    delete [] blockCache;
+    delete [] blocksInFrame;
     if (tlb != NULL)
         delete [] tlb;
 }
@@ -95,19 +129,25 @@ Machine::~Machine()
 //
 //	"which" -- the cause of the kernel trap
 //	"badVaddr" -- the virtual address causing the trap, if appropriate
+//
+//	The kernel itself may cause an exception, when it reads or writes
+//	user memory in a system call (see ReadMem and WriteMem); it then
+//	carries on in the kernel once the exception has been handled.
 //----------------------------------------------------------------------
 
 void
 Machine::RaiseException(ExceptionType which, int badVAddr)
 {
+    MachineStatus old = interrupt->getStatus();
+
     DEBUG('m', "Exception: %s\n", exceptionNames[which]);
     
-//  ASSERT(interrupt->getStatus() == UserMode);
     registers[BadVAddrReg] = badVAddr;
     DelayedLoad(0, 0);			// finish anything in progress
+    userTrap = (old == UserMode);
     interrupt->setStatus(SystemMode);
     ExceptionHandler(which);		// interrupts are enabled at this point
-    interrupt->setStatus(UserMode);
+    interrupt->setStatus(old);
 }
 
 //----------------------------------------------------------------------
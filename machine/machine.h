@@ -35,6 +35,12 @@
 #define NumPhysPages    64
 #define MemorySize 	(NumPhysPages * PageSize)
 #define TLBSize		4		// if there is a TLB, make it small
+#define NumMemWords	(MemorySize / 4) // predecoded instruction slots
+#define SoftTLBSize	16		// entries in the simulator's private
+					// translation cache; keep a power of 2
+
+class BasicBlock;
+class Profile;
 
 enum ExceptionType { NoException,           // Everything ok!
 		     SyscallException,      // A program executed a system call.
@@ -91,6 +97,20 @@ class Instruction {
                      // Immediates are sign-extended.
 };
 
+// The following class defines an entry in the soft TLB -- a small,
+// direct-mapped cache of recent virtual page -> mainMemory translations
+// that lets ReadMem/WriteMem skip Translate on the common path.  Unlike
+// the MIPS TLB below, it is invisible to the Nachos kernel, except that
+// the kernel has to flush it when it changes a translation.
+
+class SoftTLBEntry {
+  public:
+    int virtualPage;	// virtual page cached here, or -1 if none
+    char *page;		// where that page lives in mainMemory
+    bool writable;	// TRUE if stores may bypass Translate (the page
+			// is already dirty and not read-only)
+};
+
 // The following class defines the simulated host workstation hardware, as 
 // seen by user programs -- the CPU registers, main memory, etc.
 // User programs shouldn't be able to tell that they are running on our 
@@ -106,8 +126,10 @@ class Instruction {
 
 class Machine {
   public:
-    Machine(bool debug);	// Initialize the simulation of the hardware
-				// for running user programs
+    Machine(bool debug, bool blocks, int tlbEntries);
+				// Initialize the simulation of the hardware
+				// for running user programs, with a TLB of
+				// "tlbEntries" entries (0 for none)
     ~Machine();			// De-allocate the data structures
 
 // Routines callable by the Nachos kernel
@@ -121,8 +143,27 @@ class Machine {
 
 // Routines internal to the machine simulation -- DO NOT call these 
 
-    void OneInstruction(Instruction *instr); 	
-    				// Run one instruction of a user program.
+    bool OneInstruction(); 	// Run one instruction of a user program;
+				// FALSE if it trapped to the kernel
+    bool Execute(Instruction *instr);
+    				// Carry out a decoded instruction; FALSE
+				// if it raised an exception
+    Instruction *FetchDecoded(int physAddr);
+    				// Return the decoded form of the word at
+				// "physAddr", decoding it only if it has
+				// changed since the last time we saw it
+    void InvalidateDecoded(int physAddr, int size);
+    				// Forget predecoded instructions covering
+				// "size" bytes of mainMemory at "physAddr".
+				// Must be called whenever that memory is
+				// changed behind the simulator's back
+				// (page-in, frame reuse, kernel copies).
+    void RunBlock(int budget);	// Run (at most "budget" instructions of)
+				// one basic block of a user program
+    BasicBlock *BuildBlock(int physAddr);
+    				// Translate the code at "physAddr" into a
+				// threaded-code block (blocksim.cc)
+    void DropBlocks(int frame);	// Forget the blocks in a physical page
     void DelayedLoad(int nextReg, int nextVal);  	
 				// Do a pending delayed load (modifying a reg)
     
@@ -139,6 +180,14 @@ class Machine {
     				// and return an exception code if the 
 				// translation couldn't be completed.
 
+    ExceptionType TranslateFetch(int virtAddr, int* physAddr);
+    				// Translate the address of an instruction,
+				// trying the soft TLB first
+
+    void FlushSoftTLB();	// Forget all cached translations
+    void FlushSoftTLBPage(int vpn);
+    				// Forget the cached translation for "vpn"
+
     void RaiseException(ExceptionType which, int badVAddr);
 				// Trap to the Nachos kernel, because of a
 				// system call or other exception.  
@@ -161,14 +210,17 @@ class Machine {
 // NOTE: the hardware translation of virtual addresses in the user program
 // to physical addresses (relative to the beginning of "mainMemory")
 // can be controlled by one of:
-//	a traditional linear page table
+//	a traditional linear page table (a two-level one, in the VM build;
+//	  see PageTableSpan in translate.h)
 //  	a software-loaded translation lookaside buffer (tlb) -- a cache of 
 //	  mappings of virtual page #'s to physical page #'s
 //
-// If "tlb" is NULL, the linear page table is used
+// If "tlb" is NULL, the page table is used
 // If "tlb" is non-NULL, the Nachos kernel is responsible for managing
 //	the contents of the TLB.  But the kernel can use any data structure
 //	it wants (eg, segmented paging) for handling TLB cache misses.
+//	Entries are tagged with an address space ID; only those tagged
+//	with "currentASID" match.
 // 
 // For simplicity, both the page table pointer and the TLB pointer are
 // public.  However, while there can be multiple page tables (one per address
@@ -176,13 +228,40 @@ class Machine {
 // Thus the TLB pointer should be considered as *read-only*, although 
 // the contents of the TLB are free to be modified by the kernel software.
 
-    TranslationEntry *tlb;		// this pointer should be considered 
+    TLBEntry *tlb;			// this pointer should be considered 
 					// "read-only" to Nachos kernel code
+    int tlbSize;			// number of entries in "tlb"
+    int currentASID;			// address space ID of the running
+					// program (set instead of pageTable)
 
     TranslationEntry *pageTable;
-    unsigned int pageTableSize;
+    TranslationEntry **pageDirectory;	// the VM build's page table: entry
+					// i has the entries of pages
+					// i * PageTableSpan on, or is NULL
+    unsigned int pageTableSize;		// number of virtual pages
+
+    Profile *profile;			// where to count the instructions of
+					// the running program, or NULL (set
+					// along with pageTable)
+
+    bool userTrap;			// TRUE if the exception being handled
+					// was raised by the user program,
+					// FALSE if by the kernel touching
+					// user memory during a system call
 
   private:
+    SoftTLBEntry softTLB[SoftTLBSize];	// see SoftTLBEntry above
+    Instruction *decodedInstrs;	// predecoded copy of every word of
+				// mainMemory, indexed by physAddr / 4
+    bool *decodedValid;		// TRUE if the matching decodedInstrs
+				// slot is up to date
+    bool useBlocks;		// run user code with the basic-block
+				// engine instead of one instruction at
+				// a time
+    BasicBlock **blockCache;	// block starting at each word of
+				// mainMemory, or NULL
+    int *blocksInFrame;		// number of blocks in each physical page
+    int blockGeneration;	// bumped whenever blocks are discarded
     bool singleStep;		// drop back into the debugger after each
 				// simulated instruction
     int runUntilTime;		// drop back into the debugger when simulated
@@ -15,14 +15,125 @@
 #include "machine.h"
 #include "mipssim.h"
 #include "system.h"
+#include "profile.h"
 
 static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
 
+// The decoding and printing tables declared in mipssim.h, defined here
+// once rather than in every file that includes it
+
+OpInfo opTable[] = {
+    {SPECIAL, RFMT}, {BCOND, IFMT}, {OP_J, JFMT}, {OP_JAL, JFMT},
+    {OP_BEQ, IFMT}, {OP_BNE, IFMT}, {OP_BLEZ, IFMT}, {OP_BGTZ, IFMT},
+    {OP_ADDI, IFMT}, {OP_ADDIU, IFMT}, {OP_SLTI, IFMT}, {OP_SLTIU, IFMT},
+    {OP_ANDI, IFMT}, {OP_ORI, IFMT}, {OP_XORI, IFMT}, {OP_LUI, IFMT},
+    {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT},
+    {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT},
+    {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT},
+    {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT},
+    {OP_LB, IFMT}, {OP_LH, IFMT}, {OP_LWL, IFMT}, {OP_LW, IFMT},
+    {OP_LBU, IFMT}, {OP_LHU, IFMT}, {OP_LWR, IFMT}, {OP_RES, IFMT},
+    {OP_SB, IFMT}, {OP_SH, IFMT}, {OP_SWL, IFMT}, {OP_SW, IFMT},
+    {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_SWR, IFMT}, {OP_RES, IFMT},
+    {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT},
+    {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT},
+    {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT},
+    {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}
+};
+
+int specialTable[] = {
+    OP_SLL, OP_RES, OP_SRL, OP_SRA, OP_SLLV, OP_RES, OP_SRLV, OP_SRAV,
+    OP_JR, OP_JALR, OP_RES, OP_RES, OP_SYSCALL, OP_UNIMP, OP_RES, OP_RES,
+    OP_MFHI, OP_MTHI, OP_MFLO, OP_MTLO, OP_RES, OP_RES, OP_RES, OP_RES,
+    OP_MULT, OP_MULTU, OP_DIV, OP_DIVU, OP_RES, OP_RES, OP_RES, OP_RES,
+    OP_ADD, OP_ADDU, OP_SUB, OP_SUBU, OP_AND, OP_OR, OP_XOR, OP_NOR,
+    OP_RES, OP_RES, OP_SLT, OP_SLTU, OP_RES, OP_RES, OP_RES, OP_RES,
+    OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES,
+    OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES
+};
+
+struct OpString opStrings[] = {
+    {"Shouldn't happen", {NONE, NONE, NONE}},
+    {"ADD r%d,r%d,r%d", {RD, RS, RT}},
+    {"ADDI r%d,r%d,%d", {RT, RS, EXTRA}},
+    {"ADDIU r%d,r%d,%d", {RT, RS, EXTRA}},
+    {"ADDU r%d,r%d,r%d", {RD, RS, RT}},
+    {"AND r%d,r%d,r%d", {RD, RS, RT}},
+    {"ANDI r%d,r%d,%d", {RT, RS, EXTRA}},
+    {"BEQ r%d,r%d,%d", {RS, RT, EXTRA}},
+    {"BGEZ r%d,%d", {RS, EXTRA, NONE}},
+    {"BGEZAL r%d,%d", {RS, EXTRA, NONE}},
+    {"BGTZ r%d,%d", {RS, EXTRA, NONE}},
+    {"BLEZ r%d,%d", {RS, EXTRA, NONE}},
+    {"BLTZ r%d,%d", {RS, EXTRA, NONE}},
+    {"BLTZAL r%d,%d", {RS, EXTRA, NONE}},
+    {"BNE r%d,r%d,%d", {RS, RT, EXTRA}},
+    {"Shouldn't happen", {NONE, NONE, NONE}},
+    {"DIV r%d,r%d", {RS, RT, NONE}},
+    {"DIVU r%d,r%d", {RS, RT, NONE}},
+    {"J %d", {EXTRA, NONE, NONE}},
+    {"JAL %d", {EXTRA, NONE, NONE}},
+    {"JALR r%d,r%d", {RD, RS, NONE}},
+    {"JR r%d,r%d", {RD, RS, NONE}},
+    {"LB r%d,%d(r%d)", {RT, EXTRA, RS}},
+    {"LBU r%d,%d(r%d)", {RT, EXTRA, RS}},
+    {"LH r%d,%d(r%d)", {RT, EXTRA, RS}},
+    {"LHU r%d,%d(r%d)", {RT, EXTRA, RS}},
+    {"LUI r%d,%d", {RT, EXTRA, NONE}},
+    {"LW r%d,%d(r%d)", {RT, EXTRA, RS}},
+    {"LWL r%d,%d(r%d)", {RT, EXTRA, RS}},
+    {"LWR r%d,%d(r%d)", {RT, EXTRA, RS}},
+    {"Shouldn't happen", {NONE, NONE, NONE}},
+    {"MFHI r%d", {RD, NONE, NONE}},
+    {"MFLO r%d", {RD, NONE, NONE}},
+    {"Shouldn't happen", {NONE, NONE, NONE}},
+    {"MTHI r%d", {RS, NONE, NONE}},
+    {"MTLO r%d", {RS, NONE, NONE}},
+    {"MULT r%d,r%d", {RS, RT, NONE}},
+    {"MULTU r%d,r%d", {RS, RT, NONE}},
+    {"NOR r%d,r%d,r%d", {RD, RS, RT}},
+    {"OR r%d,r%d,r%d", {RD, RS, RT}},
+    {"ORI r%d,r%d,%d", {RT, RS, EXTRA}},
+    {"RFE", {NONE, NONE, NONE}},
+    {"SB r%d,%d(r%d)", {RT, EXTRA, RS}},
+    {"SH r%d,%d(r%d)", {RT, EXTRA, RS}},
+    {"SLL r%d,r%d,%d", {RD, RT, EXTRA}},
+    {"SLLV r%d,r%d,r%d", {RD, RT, RS}},
+    {"SLT r%d,r%d,r%d", {RD, RS, RT}},
+    {"SLTI r%d,r%d,%d", {RT, RS, EXTRA}},
+    {"SLTIU r%d,r%d,%d", {RT, RS, EXTRA}},
+    {"SLTU r%d,r%d,r%d", {RD, RS, RT}},
+    {"SRA r%d,r%d,%d", {RD, RT, EXTRA}},
+    {"SRAV r%d,r%d,r%d", {RD, RT, RS}},
+    {"SRL r%d,r%d,%d", {RD, RT, EXTRA}},
+    {"SRLV r%d,r%d,r%d", {RD, RT, RS}},
+    {"SUB r%d,r%d,r%d", {RD, RS, RT}},
+    {"SUBU r%d,r%d,r%d", {RD, RS, RT}},
+    {"SW r%d,%d(r%d)", {RT, EXTRA, RS}},
+    {"SWL r%d,%d(r%d)", {RT, EXTRA, RS}},
+    {"SWR r%d,%d(r%d)", {RT, EXTRA, RS}},
+    {"XOR r%d,r%d,r%d", {RD, RS, RT}},
+    {"XORI r%d,r%d,%d", {RT, RS, EXTRA}},
+    {"SYSCALL", {NONE, NONE, NONE}},
+    {"Unimplemented", {NONE, NONE, NONE}},
+    {"Reserved", {NONE, NONE, NONE}}
+};
+
 //----------------------------------------------------------------------
 // Machine::Run
 // 	Simulate the execution of a user-level program on Nachos.
 //	Called by the kernel when the program starts up; never returns.
 //
+//	Depending on how the Machine was created, user code is run either
+//	one instruction at a time, or a basic block at a time (RunBlock).
+//
+//	Rather than checking for interrupts after every instruction, we
+//	ask the interrupt simulation how many instructions can run before
+//	the next one could be due, and run that many with nothing but the
+//	clock being advanced.  Since the kernel may schedule interrupts
+//	or switch threads on any trap, a batch ends at the first trap.
+//	Interrupts therefore still arrive at exactly the same instruction.
+//
 //	This routine is re-entrant, in that it can be called multiple
 //	times concurrently -- one for each thread executing user code.
 //----------------------------------------------------------------------
@@ -30,15 +141,34 @@ static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
 void
 Machine::Run()
 {
-    Instruction *instr = new Instruction;  // storage for decoded instruction
-
     if(DebugIsEnabled('m'))
         printf("Starting thread \"%s\" at time %d\n",
                currentThread->getName(), stats->totalTicks);
     interrupt->setStatus(UserMode);
+    bool tracing = DebugIsEnabled('m');
     for (;;) {
-        OneInstruction(instr);
-        interrupt->OneTick();
+        int quiet = 0;			// instructions before an interrupt
+        				// may be due
+        if (!singleStep && !tracing)
+            quiet = interrupt->UserTicksUntilDue();
+
+        if (quiet == 0) {
+            OneInstruction();
+            interrupt->OneTick();
+        } else if (useBlocks && profile == NULL &&
+                   registers[NextPCReg] == registers[PCReg] + 4) {
+            // Whole blocks can only be entered when we aren't profiling
+            // and aren't about to execute a branch delay slot.
+            RunBlock(quiet);
+        } else {
+            for (int i = 0; i < quiet; i++) {
+                if (!OneInstruction()) {	// the kernel ran; it may
+                    interrupt->OneTick();	// have made something due
+                    break;
+                }
+                interrupt->AdvanceUserTicks(1);
+            }
+        }
         if (singleStep && (runUntilTime <= stats->totalTicks))
             Debugger();
     }
@@ -88,21 +218,27 @@ TypeToReg(RegType reg, Instruction *instr)
 //	leaving.  This allows the Nachos kernel to control our behavior
 //	by controlling the contents of memory, the translation table,
 //	and the register set.
+//
+//	The only thing we do remember is the decoded form of each word of
+//	physical memory (see FetchDecoded); that is keyed by physical
+//	address and dropped whenever the word changes, so it can't leak
+//	state between threads.
 //----------------------------------------------------------------------
 
-void
-Machine::OneInstruction(Instruction *instr)
+bool
+Machine::OneInstruction()
 {
-    int raw;
-    int nextLoadReg = 0;
-    int nextLoadValue = 0; 	// record delayed load operation, to apply
-    // in the future
+    Instruction *instr;
+    int physAddr;
+    ExceptionType exception;
 
     // Fetch instruction
-    if (!machine->ReadMem(registers[PCReg], 4, &raw))
-        return;			// exception occurred
-    instr->value = raw;
-    instr->Decode();
+    exception = TranslateFetch(registers[PCReg], &physAddr);
+    if (exception != NoException) {
+        RaiseException(exception, registers[PCReg]);
+        return FALSE;
+    }
+    instr = FetchDecoded(physAddr);
 
     if (DebugIsEnabled('m')) {
         struct OpString *str = &opStrings[instr->opCode];
@@ -114,6 +250,40 @@ Machine::OneInstruction(Instruction *instr)
         printf("\n");
     }
 
+    if (profile != NULL) {
+        // Count the instruction once it has completed (a syscall
+        // completes in the kernel; other exceptions restart it).
+        Profile *counting = profile;
+        int pc = registers[PCReg];
+        int nextPC = registers[NextPCReg];
+        bool completed = Execute(instr);
+
+        if (completed || instr->opCode == OP_SYSCALL)
+            counting->Count(pc, instr->opCode,
+                            completed && registers[NextPCReg] != nextPC + 4);
+        return completed;
+    }
+    return Execute(instr);
+}
+
+//----------------------------------------------------------------------
+// Machine::Execute
+// 	Carry out an already-fetched and decoded instruction, including
+//	any pending delayed load and the update of the program counters.
+//	Shared by OneInstruction and the basic-block engine (blocksim.cc),
+//	which uses it for every opcode it has no specialized handler for.
+//
+//	Returns FALSE if the instruction trapped to the kernel, in which
+//	case the program counters were left alone.
+//----------------------------------------------------------------------
+
+bool
+Machine::Execute(Instruction *instr)
+{
+    int nextLoadReg = 0;
+    int nextLoadValue = 0; 	// record delayed load operation, to apply
+    // in the future
+
     // Compute next pc, but don't install in case there's an error or branch.
     int pcAfter = registers[NextPCReg] + 4;
     int sum, diff, tmp, value;
@@ -127,7 +297,7 @@ Machine::OneInstruction(Instruction *instr)
         if (!((registers[instr->rs] ^ registers[instr->rt]) & SIGN_BIT) &&
                 ((registers[instr->rs] ^ sum) & SIGN_BIT)) {
             RaiseException(OverflowException, 0);
-            return;
+            return FALSE;
         }
         registers[instr->rd] = sum;
         break;
@@ -137,7 +307,7 @@ Machine::OneInstruction(Instruction *instr)
         if (!((registers[instr->rs] ^ instr->extra) & SIGN_BIT) &&
                 ((instr->extra ^ sum) & SIGN_BIT)) {
             RaiseException(OverflowException, 0);
-            return;
+            return FALSE;
         }
         registers[instr->rt] = sum;
         break;
@@ -232,7 +402,7 @@ Machine::OneInstruction(Instruction *instr)
     case OP_LBU:
         tmp = registers[instr->rs] + instr->extra;
         if (!machine->ReadMem(tmp, 1, &value))
-            return;
+            return FALSE;
 
         if ((value & 0x80) && (instr->opCode == OP_LB))
             value |= 0xffffff00;
@@ -247,10 +417,10 @@ Machine::OneInstruction(Instruction *instr)
         tmp = registers[instr->rs] + instr->extra;
         if (tmp & 0x1) {
             RaiseException(AddressErrorException, tmp);
-            return;
+            return FALSE;
         }
         if (!machine->ReadMem(tmp, 2, &value))
-            return;
+            return FALSE;
 
         if ((value & 0x8000) && (instr->opCode == OP_LH))
             value |= 0xffff0000;
@@ -269,10 +439,10 @@ Machine::OneInstruction(Instruction *instr)
         tmp = registers[instr->rs] + instr->extra;
         if (tmp & 0x3) {
             RaiseException(AddressErrorException, tmp);
-            return;
+            return FALSE;
         }
         if (!machine->ReadMem(tmp, 4, &value))
-            return;
+            return FALSE;
         nextLoadReg = instr->rt;
         nextLoadValue = value;
         break;
@@ -286,7 +456,7 @@ Machine::OneInstruction(Instruction *instr)
         ASSERT((tmp & 0x3) == 0);
 
         if (!machine->ReadMem(tmp, 4, &value))
-            return;
+            return FALSE;
         if (registers[LoadReg] == instr->rt)
             nextLoadValue = registers[LoadValueReg];
         else
@@ -317,7 +487,7 @@ Machine::OneInstruction(Instruction *instr)
         ASSERT((tmp & 0x3) == 0);
 
         if (!machine->ReadMem(tmp, 4, &value))
-            return;
+            return FALSE;
         if (registers[LoadReg] == instr->rt)
             nextLoadValue = registers[LoadValueReg];
         else
@@ -383,13 +553,13 @@ Machine::OneInstruction(Instruction *instr)
     case OP_SB:
         if (!machine->WriteMem((unsigned)
                                (registers[instr->rs] + instr->extra), 1, registers[instr->rt]))
-            return;
+            return FALSE;
         break;
 
     case OP_SH:
         if (!machine->WriteMem((unsigned)
                                (registers[instr->rs] + instr->extra), 2, registers[instr->rt]))
-            return;
+            return FALSE;
         break;
 
     case OP_SLL:
@@ -459,7 +629,7 @@ Machine::OneInstruction(Instruction *instr)
         if (((registers[instr->rs] ^ registers[instr->rt]) & SIGN_BIT) &&
                 ((registers[instr->rs] ^ diff) & SIGN_BIT)) {
             RaiseException(OverflowException, 0);
-            return;
+            return FALSE;
         }
         registers[instr->rd] = diff;
         break;
@@ -471,7 +641,7 @@ Machine::OneInstruction(Instruction *instr)
     case OP_SW:
         if (!machine->WriteMem((unsigned)
                                (registers[instr->rs] + instr->extra), 4, registers[instr->rt]))
-            return;
+            return FALSE;
         break;
 
     case OP_SWL:
@@ -482,7 +652,7 @@ Machine::OneInstruction(Instruction *instr)
         ASSERT((tmp & 0x3) == 0);
 
         if (!machine->ReadMem((tmp & ~0x3), 4, &value))
-            return;
+            return FALSE;
         switch (tmp & 0x3) {
         case 0:
             value = registers[instr->rt];
@@ -501,7 +671,7 @@ Machine::OneInstruction(Instruction *instr)
             break;
         }
         if (!machine->WriteMem((tmp & ~0x3), 4, value))
-            return;
+            return FALSE;
         break;
 
     case OP_SWR:
@@ -512,7 +682,7 @@ Machine::OneInstruction(Instruction *instr)
         ASSERT((tmp & 0x3) == 0);
 
         if (!machine->ReadMem((tmp & ~0x3), 4, &value))
-            return;
+            return FALSE;
         switch (tmp & 0x3) {
         case 0:
             value = (value & 0xffffff) | (registers[instr->rt] << 24);
@@ -528,12 +698,12 @@ Machine::OneInstruction(Instruction *instr)
             break;
         }
         if (!machine->WriteMem((tmp & ~0x3), 4, value))
-            return;
+            return FALSE;
         break;
 
     case OP_SYSCALL:
         RaiseException(SyscallException, 0);
-        return;
+        return FALSE;
 
     case OP_XOR:
         registers[instr->rd] = registers[instr->rs] ^ registers[instr->rt];
@@ -546,7 +716,7 @@ Machine::OneInstruction(Instruction *instr)
     case OP_RES:
     case OP_UNIMP:
         RaiseException(IllegalInstrException, 0);
-        return;
+        return FALSE;
 
     default:
         ASSERT(FALSE);
@@ -562,6 +732,7 @@ Machine::OneInstruction(Instruction *instr)
     // are jumping into lala-land
     registers[PCReg] = registers[NextPCReg];
     registers[NextPCReg] = pcAfter;
+    return TRUE;
 }
 
 //----------------------------------------------------------------------
@@ -581,6 +752,49 @@ Machine::DelayedLoad(int nextReg, int nextValue)
     registers[0] = 0; 	// and always make sure R0 stays zero.
 }
 
+//----------------------------------------------------------------------
+// Machine::FetchDecoded
+// 	Return the decoded instruction stored at "physAddr" in mainMemory.
+//	Decoding is only done the first time we execute a word after it
+//	was last written; tight loops otherwise re-use the cached copy.
+//
+//	"physAddr" -- word-aligned physical address of the instruction
+//----------------------------------------------------------------------
+
+Instruction *
+Machine::FetchDecoded(int physAddr)
+{
+    int word = physAddr / 4;
+    Instruction *instr = &decodedInstrs[word];
+
+    if (!decodedValid[word]) {
+        instr->value = WordToHost(*(unsigned int *) &mainMemory[physAddr]);
+        instr->Decode();
+        decodedValid[word] = TRUE;
+    }
+    return instr;
+}
+
+//----------------------------------------------------------------------
+// Machine::InvalidateDecoded
+// 	Throw away any predecoded instructions for the words overlapping
+//	"size" bytes of mainMemory starting at "physAddr".
+//----------------------------------------------------------------------
+
+void
+Machine::InvalidateDecoded(int physAddr, int size)
+{
+    int first = physAddr / 4;
+    int last = (physAddr + size - 1) / 4;
+
+    for (int i = first; i <= last; i++)
+        decodedValid[i] = FALSE;
+    for (int frame = physAddr / PageSize;
+            frame <= (physAddr + size - 1) / PageSize; frame++)
+        if (blocksInFrame[frame] > 0)
+            DropBlocks(frame);
+}
+
 //----------------------------------------------------------------------
 // Instruction::Decode
 // 	Decode a MIPS instruction
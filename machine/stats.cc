@@ -22,6 +22,8 @@ Statistics::Statistics()
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numSyscalls = 0;
+    numTLBHits = numTLBMisses = 0;
 }
 
 //----------------------------------------------------------------------
@@ -39,6 +41,128 @@ Statistics::Print()
     printf("Console I/O: reads %d, writes %d\n", numConsoleCharsRead,
            numConsoleCharsWritten);
     printf("Paging: faults %d\n", numPageFaults);
+    if (numTLBHits + numTLBMisses > 0)
+	printf("TLB: hits %d, misses %d, hit rate %.2f%%\n", numTLBHits,
+	       numTLBMisses, 100.0 * numTLBHits / (numTLBHits + numTLBMisses));
+    printf("System calls: %d\n", numSyscalls);
     printf("Network I/O: packets received %d, sent %d\n", numPacketsRecvd,
            numPacketsSent);
 }
+
+//----------------------------------------------------------------------
+// PagingStatistics::PagingStatistics
+// 	Initialize the paging counters of process "owner" (or -1, for
+//	the totals) to zero.
+//----------------------------------------------------------------------
+
+PagingStatistics::PagingStatistics(int owner)
+{
+    pid = owner;
+    faultsShared = faultsSwap = faultsFile = faultsZeroFill = 0;
+    faultsCopyOnWrite = readAheadPages = 0;
+    evictionsClean = evictionsDirty = 0;
+    swapReads = swapPagesRead = swapWrites = fileWrites = 0;
+    faultTicks = maxFaultTicks = 0;
+    residentSamples = residentSum = residentMax = 0;
+}
+
+//----------------------------------------------------------------------
+// PagingStatistics::Faults
+// 	Return the number of page faults, of whatever kind.
+//----------------------------------------------------------------------
+
+int
+PagingStatistics::Faults()
+{
+    return faultsShared + faultsSwap + faultsFile + faultsZeroFill +
+	faultsCopyOnWrite;
+}
+
+//----------------------------------------------------------------------
+// PagingStatistics::FaultHandled
+// 	Account for a page fault that took "ticks" to handle.
+//----------------------------------------------------------------------
+
+void
+PagingStatistics::FaultHandled(int ticks)
+{
+    faultTicks += ticks;
+    if (ticks > maxFaultTicks)
+	maxFaultTicks = ticks;
+}
+
+//----------------------------------------------------------------------
+// PagingStatistics::SampleResidency
+// 	Record that "pages" pages are resident right now.
+//----------------------------------------------------------------------
+
+void
+PagingStatistics::SampleResidency(int pages)
+{
+    residentSamples++;
+    residentSum += pages;
+    if (pages > residentMax)
+	residentMax = pages;
+}
+
+//----------------------------------------------------------------------
+// PagingStatistics::Add
+// 	Add the event counts of "other" into ours.  The resident set
+//	samples aren't added up: the total resident set is sampled on
+//	its own.
+//----------------------------------------------------------------------
+
+void
+PagingStatistics::Add(PagingStatistics *other)
+{
+    faultsShared += other->faultsShared;
+    faultsSwap += other->faultsSwap;
+    faultsFile += other->faultsFile;
+    faultsZeroFill += other->faultsZeroFill;
+    faultsCopyOnWrite += other->faultsCopyOnWrite;
+    readAheadPages += other->readAheadPages;
+    evictionsClean += other->evictionsClean;
+    evictionsDirty += other->evictionsDirty;
+    swapReads += other->swapReads;
+    swapPagesRead += other->swapPagesRead;
+    swapWrites += other->swapWrites;
+    fileWrites += other->fileWrites;
+    faultTicks += other->faultTicks;
+    if (other->maxFaultTicks > maxFaultTicks)
+	maxFaultTicks = other->maxFaultTicks;
+}
+
+//----------------------------------------------------------------------
+// PagingStatistics::PrintHeader
+// 	Print the names of the columns PagingStatistics::Print prints.
+//----------------------------------------------------------------------
+
+void
+PagingStatistics::PrintHeader(FILE *out)
+{
+    fprintf(out, "pid,faults,shared,swap,file,zerofill,cow,readahead,"
+	    "evict_clean,evict_dirty,swap_reads,swap_pages_read,swap_writes,"
+	    "file_writes,fault_ticks,max_fault_ticks,rss_samples,rss_mean,rss_max\n");
+}
+
+//----------------------------------------------------------------------
+// PagingStatistics::Print
+// 	Print the counters as one line of comma separated values; the
+//	totals have "all" in place of a pid.
+//----------------------------------------------------------------------
+
+void
+PagingStatistics::Print(FILE *out)
+{
+    if (pid < 0)
+	fprintf(out, "all,");
+    else
+	fprintf(out, "%d,", pid);
+    fprintf(out, "%d,%d,%d,%d,%d,%d,%d,", Faults(), faultsShared, faultsSwap,
+	    faultsFile, faultsZeroFill, faultsCopyOnWrite, readAheadPages);
+    fprintf(out, "%d,%d,%d,%d,%d,%d,", evictionsClean, evictionsDirty,
+	    swapReads, swapPagesRead, swapWrites, fileWrites);
+    fprintf(out, "%d,%d,%d,%.2f,%d\n", faultTicks, maxFaultTicks,
+	    residentSamples, residentSamples == 0 ? 0.0 :
+	    (double) residentSum / residentSamples, residentMax);
+}
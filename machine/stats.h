@@ -12,6 +12,7 @@
 #define STATS_H
 
 #include "copyright.h"
+#include <stdio.h>
 
 // The following class defines the statistics that are to be kept
 // about Nachos behavior -- how much time (ticks) elapsed, how
@@ -33,6 +34,9 @@ public:
     int numConsoleCharsRead;	// number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numPageFaults;		// number of virtual memory page faults
+    int numTLBHits;		// translations found in the TLB, if
+    int numTLBMisses;		// there is one, and not found there
+    int numSyscalls;		// number of system calls made by user programs
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
 
@@ -41,6 +45,45 @@ public:
     void Print();		// print collected statistics
 };
 
+// What the virtual memory system did on behalf of one process (kept in
+// its PCB), or of all of them.  Each page fault is counted by where
+// the page came from: a frame another process already had it in, the
+// swap file, the executable, or nowhere (zero-filled).
+//
+// The resident set is sampled every ResidencySampleTicks; the samples
+// are summed, so the average is residentSum / residentSamples.
+
+class PagingStatistics {
+public:
+    int pid;			// whose they are, or -1 for everybody
+    int faultsShared;		// page faults by where the page came from
+    int faultsSwap;
+    int faultsFile;
+    int faultsZeroFill;
+    int faultsCopyOnWrite;	// writes to a page shared copy-on-write
+    int readAheadPages;		// pages brought in after a faulting one
+    int evictionsClean;		// pages evicted without writing them out
+    int evictionsDirty;		// pages written out to be evicted
+    int swapReads;		// read requests to the swap file
+    int swapPagesRead;		// pages they read
+    int swapWrites;		// pages written to the swap file
+    int fileWrites;		// pages written back to mapped files
+    int faultTicks;		// time spent handling page faults
+    int maxFaultTicks;		// the slowest one
+    int residentSamples;	// number of resident set samples
+    int residentSum;		// their total, in pages
+    int residentMax;		// the largest
+
+    PagingStatistics(int owner = -1);	// initialize everything to zero
+
+    int Faults();		// page faults of every kind
+    void FaultHandled(int ticks);	// count the time for one fault
+    void SampleResidency(int pages);	// take a resident set sample
+    void Add(PagingStatistics *other);	// add in another's counts
+    static void PrintHeader(FILE *out);	// column names, for Print
+    void Print(FILE *out);	// print as a line of comma separated values
+};
+
 // Constants used to reflect the relative time an operation would
 // take in a real system.  A "tick" is a just a unit of time -- if you
 // like, a microsecond.
@@ -53,8 +96,10 @@ public:
 #define SystemTick 	10 	// advance each time interrupts are enabled
 #define RotationTime 	500 	// time disk takes to rotate one sector
 #define SeekTime 	500    	// time disk takes to seek past one track
+#define DiskTicks 	1000	// time to move a page to or from the stub disk
 #define ConsoleTime 	100	// time to read or write one character
 #define NetworkTime 	100   	// time to send or receive one packet
 #define TimerTicks 	100    	// (average) time between timer interrupts
+#define ResidencySampleTicks 1000	// time between resident set samples
 
 #endif // STATS_H
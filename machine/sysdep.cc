@@ -35,6 +35,7 @@ extern "C" {
 #include <sys/file.h>
 #include <sys/un.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #ifdef HOST_i386
 #include <unistd.h>
 #include <sys/time.h>
@@ -254,6 +255,46 @@ Close(int fd)
     ASSERT(retVal >= 0);
 }
 
+//----------------------------------------------------------------------
+// MapFile
+// 	Map the file "name" into our address space, read-only (changes
+//	made through the mapping are private).  Returns the address of
+//	the data and sets "*size" to its length, or returns NULL if the
+//	file can't be opened or mapped.
+//----------------------------------------------------------------------
+
+char *
+MapFile(char *name, int *size)
+{
+    struct stat info;
+    char *data;
+    int fd = open(name, O_RDONLY, 0);
+
+    if (fd < 0)
+	return NULL;
+    if (fstat(fd, &info) < 0 || info.st_size == 0) {
+	close(fd);
+	return NULL;
+    }
+    data = (char *) mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);				// the mapping stays valid
+    if (data == (char *) MAP_FAILED)
+	return NULL;
+    *size = info.st_size;
+    return data;
+}
+
+//----------------------------------------------------------------------
+// UnmapFile
+// 	Undo MapFile.
+//----------------------------------------------------------------------
+
+void
+UnmapFile(char *data, int size)
+{
+    (void) munmap(data, size);
+}
+
 //----------------------------------------------------------------------
 // Unlink
 // 	Delete a file.
@@ -29,6 +29,10 @@ extern int Tell(int fd);
 extern void Close(int fd);
 extern bool Unlink(char *name);
 
+// Map a whole file into memory, read-only, for fast loading
+extern char *MapFile(char *name, int *size);
+extern void UnmapFile(char *data, int size);
+
 // Interprocess communication operations, for simulating the network
 extern int OpenSocket();
 extern void CloseSocket(int sockID);
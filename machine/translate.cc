@@ -92,6 +92,25 @@ Machine::ReadMem(int addr, int size, int *value)
     int data;
     ExceptionType exception;
     int physicalAddress;
+    unsigned int vpn = (unsigned) addr / PageSize;
+    SoftTLBEntry *cached = &softTLB[vpn % SoftTLBSize];
+
+    // Fast path: an aligned access to a page we translated recently
+    if (cached->virtualPage == (int) vpn && !(addr & (size - 1))) {
+    char *hostAddr = cached->page + (unsigned) addr % PageSize;
+    switch (size) {
+      case 1:
+        *value = *hostAddr;
+        break;
+      case 2:
+        *value = ShortToHost(*(unsigned short *) hostAddr);
+        break;
+      default:
+        *value = WordToHost(*(unsigned int *) hostAddr);
+        break;
+    }
+    return TRUE;
+    }
     
     DEBUG('a', "Reading VA 0x%x, size %d\n", addr, size);
     
@@ -141,7 +160,14 @@ Machine::WriteMem(int addr, int size, int value)
 {
     ExceptionType exception;
     int physicalAddress;
-     
+    unsigned int vpn = (unsigned) addr / PageSize;
+    SoftTLBEntry *cached = &softTLB[vpn % SoftTLBSize];
+
+    // Fast path: an aligned store to a page that is already dirty
+    if (cached->virtualPage == (int) vpn && cached->writable &&
+        !(addr & (size - 1))) {
+    physicalAddress = (cached->page - mainMemory) + (unsigned) addr % PageSize;
+    } else {
     DEBUG('a', "Writing VA 0x%x, size %d, value 0x%x\n", addr, size, value);
 
     exception = Translate(addr, &physicalAddress, size, TRUE);
@@ -149,6 +175,10 @@ Machine::WriteMem(int addr, int size, int value)
     machine->RaiseException(exception, addr);
     return FALSE;
     }
+    }
+    decodedValid[physicalAddress / 4] = FALSE;  // stale if this was code
+    if (blocksInFrame[physicalAddress / PageSize] > 0)
+        DropBlocks(physicalAddress / PageSize);
     switch (size) {
       case 1:
     machine->mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
@@ -202,37 +232,41 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
     }
     
     // we must have either a TLB or a page table, but not both!
-    ASSERT(tlb == NULL || pageTable == NULL);   
-    ASSERT(tlb != NULL || pageTable != NULL);   
+    ASSERT(tlb == NULL || pageDirectory == NULL);   
+    ASSERT(tlb != NULL || pageDirectory != NULL);   
 
 // calculate the virtual page number, and offset within the page,
 // from the virtual address
     vpn = (unsigned) virtAddr / PageSize;
     offset = (unsigned) virtAddr % PageSize;
     
-    if (tlb == NULL) {      // => page table => vpn is index into table
+    if (tlb == NULL) {      // => two-level page table
     if (vpn >= pageTableSize) {
         DEBUG('a', "virtual page # %d too large for page table size %d!\n", 
             virtAddr, pageTableSize);
         return AddressErrorException;
-    } else if (!pageTable[vpn].valid) {
-        DEBUG('a', "virtual page # %d too large for page table size %d!\n", 
-            virtAddr, pageTableSize);
+    }
+    entry = pageDirectory[vpn / PageTableSpan];
+    if (entry == NULL || !entry[vpn % PageTableSpan].valid) {
+        DEBUG('a', "virtual page # %d not in memory!\n", vpn);
         return PageFaultException;
     }
-    entry = &pageTable[vpn];
+    entry += vpn % PageTableSpan;
     } else {
-        for (entry = NULL, i = 0; i < TLBSize; i++)
-            if (tlb[i].valid && (((unsigned int)tlb[i].virtualPage) == vpn)) {
+        for (entry = NULL, i = 0; i < tlbSize; i++)
+            if (tlb[i].valid && tlb[i].asid == currentASID &&
+                (((unsigned int)tlb[i].virtualPage) == vpn)) {
         entry = &tlb[i];            // FOUND!
         break;
         }
     if (entry == NULL) {                // not found
             DEBUG('a', "*** no valid TLB entry found for this virtual page!\n");
+            stats->numTLBMisses++;
             return PageFaultException;      // really, this is a TLB fault,
                         // the page may be in memory,
                         // but not in the TLB
     }
+    stats->numTLBHits++;
     }
 
     if (entry->readOnly && writing) {   // trying to write to a read-only page
@@ -259,6 +293,16 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
     *physAddr = pageFrame * PageSize + offset;
     ASSERT((*physAddr >= 0) && ((*physAddr + size) <= MemorySize));
     DEBUG('a', "phys addr = 0x%x\n", *physAddr);
+
+    // Remember the translation, so the next access to this page can
+    // skip all of the above.  Stores only bypass us once the page is
+    // dirty, so the dirty bit is still set by the first write.
+    if (tlb == NULL) {
+    SoftTLBEntry *cached = &softTLB[vpn % SoftTLBSize];
+    cached->virtualPage = vpn;
+    cached->page = mainMemory + pageFrame * PageSize;
+    cached->writable = entry->dirty && !entry->readOnly;
+    }
     return NoException;
 }
 
@@ -320,6 +364,25 @@ Machine::ReadMem(int addr, int size, int *value)
     int data;
     ExceptionType exception;
     int physicalAddress;
+    unsigned int vpn = (unsigned) addr / PageSize;
+    SoftTLBEntry *cached = &softTLB[vpn % SoftTLBSize];
+
+    // Fast path: an aligned access to a page we translated recently
+    if (cached->virtualPage == (int) vpn && !(addr & (size - 1))) {
+    char *hostAddr = cached->page + (unsigned) addr % PageSize;
+    switch (size) {
+      case 1:
+        *value = *hostAddr;
+        break;
+      case 2:
+        *value = ShortToHost(*(unsigned short *) hostAddr);
+        break;
+      default:
+        *value = WordToHost(*(unsigned int *) hostAddr);
+        break;
+    }
+    return TRUE;
+    }
     
     DEBUG('a', "Reading VA 0x%x, size %d\n", addr, size);
     
@@ -369,7 +432,14 @@ Machine::WriteMem(int addr, int size, int value)
 {
     ExceptionType exception;
     int physicalAddress;
-     
+    unsigned int vpn = (unsigned) addr / PageSize;
+    SoftTLBEntry *cached = &softTLB[vpn % SoftTLBSize];
+
+    // Fast path: an aligned store to a page that is already dirty
+    if (cached->virtualPage == (int) vpn && cached->writable &&
+        !(addr & (size - 1))) {
+    physicalAddress = (cached->page - mainMemory) + (unsigned) addr % PageSize;
+    } else {
     DEBUG('a', "Writing VA 0x%x, size %d, value 0x%x\n", addr, size, value);
 
     exception = Translate(addr, &physicalAddress, size, TRUE);
@@ -377,6 +447,10 @@ Machine::WriteMem(int addr, int size, int value)
     machine->RaiseException(exception, addr);
     return FALSE;
     }
+    }
+    decodedValid[physicalAddress / 4] = FALSE;  // stale if this was code
+    if (blocksInFrame[physicalAddress / PageSize] > 0)
+        DropBlocks(physicalAddress / PageSize);
     switch (size) {
       case 1:
     machine->mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
@@ -450,17 +524,20 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
     }
     entry = &pageTable[vpn];
     } else {
-        for (entry = NULL, i = 0; i < TLBSize; i++)
-            if (tlb[i].valid && (((unsigned int)tlb[i].virtualPage) == vpn)) {
+        for (entry = NULL, i = 0; i < tlbSize; i++)
+            if (tlb[i].valid && tlb[i].asid == currentASID &&
+                (((unsigned int)tlb[i].virtualPage) == vpn)) {
         entry = &tlb[i];            // FOUND!
         break;
         }
     if (entry == NULL) {                // not found
             DEBUG('a', "*** no valid TLB entry found for this virtual page!\n");
+            stats->numTLBMisses++;
             return PageFaultException;      // really, this is a TLB fault,
                         // the page may be in memory,
                         // but not in the TLB
     }
+    stats->numTLBHits++;
     }
 
     if (entry->readOnly && writing) {   // trying to write to a read-only page
@@ -481,7 +558,66 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
     *physAddr = pageFrame * PageSize + offset;
     ASSERT((*physAddr >= 0) && ((*physAddr + size) <= MemorySize));
     DEBUG('a', "phys addr = 0x%x\n", *physAddr);
+
+    // Remember the translation, so the next access to this page can
+    // skip all of the above.  Stores only bypass us once the page is
+    // dirty, so the dirty bit is still set by the first write.
+    if (tlb == NULL) {
+    SoftTLBEntry *cached = &softTLB[vpn % SoftTLBSize];
+    cached->virtualPage = vpn;
+    cached->page = mainMemory + pageFrame * PageSize;
+    cached->writable = entry->dirty && !entry->readOnly;
+    }
     return NoException;
 }
 
 #endif // VM or non-VM
+
+//----------------------------------------------------------------------
+// Machine::TranslateFetch
+//  Translate the address of an instruction to be fetched, through the
+//  soft TLB if we can.  Same results as Translate(virtAddr, physAddr,
+//  4, FALSE).
+//----------------------------------------------------------------------
+
+ExceptionType
+Machine::TranslateFetch(int virtAddr, int* physAddr)
+{
+    unsigned int vpn = (unsigned) virtAddr / PageSize;
+    SoftTLBEntry *cached = &softTLB[vpn % SoftTLBSize];
+
+    if (cached->virtualPage == (int) vpn && !(virtAddr & 0x3)) {
+    *physAddr = (cached->page - mainMemory) + (unsigned) virtAddr % PageSize;
+    return NoException;
+    }
+    return Translate(virtAddr, physAddr, 4, FALSE);
+}
+
+//----------------------------------------------------------------------
+// Machine::FlushSoftTLB
+//  Forget every cached translation.  Must be called whenever the page
+//  table is switched.
+//----------------------------------------------------------------------
+
+void
+Machine::FlushSoftTLB()
+{
+    for (int i = 0; i < SoftTLBSize; i++)
+    softTLB[i].virtualPage = -1;
+}
+
+//----------------------------------------------------------------------
+// Machine::FlushSoftTLBPage
+//  Forget the cached translation for virtual page "vpn", if any.  Must
+//  be called whenever the kernel invalidates that page, write-protects
+//  it, or clears its use or dirty bit.
+//----------------------------------------------------------------------
+
+void
+Machine::FlushSoftTLBPage(int vpn)
+{
+    SoftTLBEntry *cached = &softTLB[(unsigned) vpn % SoftTLBSize];
+
+    if (cached->virtualPage == vpn)
+    cached->virtualPage = -1;
+}
@@ -26,25 +26,48 @@
 // virtual page to one physical page.
 // In addition, there are some extra bits for access control (valid and 
 // read-only) and some bits for usage information (use and dirty).
-
-//class AddrSpace;
+//
+// The whole entry is packed into one 32-bit word, so that a page table
+// takes as little room (and as few cache lines) as possible.  In a page
+// table, the virtual page number is just the entry's index.  The frame
+// number of an entry that isn't valid means nothing to the hardware, so
+// the kernel can keep its own information about the page there (the VM
+// kernel keeps where the page is in swap; see
+// VirtualMemoryManager::getSwapLocation).
 
 class TranslationEntry {
   public:
-    int virtualPage;  	// The page number in virtual memory.
-    int physicalPage;  	// The page number in real memory (relative to the
-			//  start of "mainMemory"
-    bool valid;         // If this bit is set, the translation is ignored.
-			// (In other words, the entry hasn't been initialized.)
-    bool readOnly;	// If this bit is set, the user program is not allowed
-			// to modify the contents of the page.
-    bool use;           // This bit is set by the hardware every time the
-			// page is referenced or modified.
-    bool dirty;         // This bit is set by the hardware every time the
-			// page is modified.
-
-  //  int locationOnDisk; // The location where disk-resident pages are loaded from
+    unsigned int physicalPage : 28;	// The page number in real memory
+			// (relative to the start of "mainMemory")
+    unsigned int valid : 1;	// If this bit is clear, the translation is
+			// ignored.  (In other words, the entry hasn't been
+			// initialized.)
+    unsigned int readOnly : 1;	// If this bit is set, the user program is
+			// not allowed to modify the contents of the page.
+    unsigned int use : 1;	// This bit is set by the hardware every time
+			// the page is referenced or modified.
+    unsigned int dirty : 1;	// This bit is set by the hardware every time
+			// the page is modified.
+};
+
+// A page table can also be in two levels: a directory, each entry of
+// which points to the entries of PageTableSpan consecutive virtual
+// pages, or is NULL if the kernel hasn't needed any of them yet.  So a
+// large address space, most of it unused, only takes room for the
+// parts that are used.
 
+#define PageTableSpan	64	// entries in a second-level table
+
+// An entry in the TLB also says which virtual page it translates, and is
+// tagged with the address space it belongs to, so that the entries of
+// several address spaces can be in the TLB at once, and it needn't be
+// flushed on a context switch.  Only the entries tagged with the
+// machine's currentASID are used for translation.
+
+class TLBEntry : public TranslationEntry {
+  public:
+    int virtualPage;	// The page number in virtual memory.
+    int asid;		// address space ID of the entry's owner
 };
 
 #endif
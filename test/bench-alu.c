@@ -0,0 +1,25 @@
+/*
+ * bench-alu.c
+ *
+ * Simulator benchmark: integer arithmetic in registers, with a branch
+ * per iteration and no memory traffic to speak of.  Measures the raw
+ * instruction rate of the interpreter.  See bench.sh.
+ */
+
+#include "syscall.h"
+
+#define ITERATIONS 1000000
+
+main()
+{
+    int i, a = 1, b = 3, c = 7;
+
+    for (i = 0; i < ITERATIONS; i++) {
+        a = a + b;
+        b = (b ^ a) + (c << 1);
+        c = c - (a >> 3);
+        if (a < 0)
+            a = -a;
+    }
+    Exit(a + b + c);
+}
@@ -0,0 +1,25 @@
+/*
+ * bench-faults.c
+ *
+ * Simulator benchmark: a page-fault storm.  The array is three times
+ * the size of physical memory, and we write one word per page, so
+ * (nearly) every access faults and evicts a dirty page.  See bench.sh.
+ */
+
+#include "syscall.h"
+
+#define PAGE 128		/* PageSize, in machine.h */
+#define SIZE (3 * 64 * PAGE)	/* three times NumPhysPages */
+#define PASSES 20
+
+char array[SIZE];
+
+main()
+{
+    int i, pass;
+
+    for (pass = 0; pass < PASSES; pass++)
+        for (i = 0; i < SIZE; i += PAGE)
+            array[i] = array[i] + 1;
+    Exit(array[0]);
+}
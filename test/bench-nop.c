@@ -0,0 +1,12 @@
+/*
+ * bench-nop.c
+ *
+ * Does nothing; bench-spawn runs it to measure Exec and Join.
+ */
+
+#include "syscall.h"
+
+main()
+{
+    Exit(0);
+}
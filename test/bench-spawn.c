@@ -0,0 +1,32 @@
+/*
+ * bench-spawn.c
+ *
+ * Simulator benchmark: process creation.  Exec and Join a trivial
+ * program over and over, then Fork a chain of children, each of which
+ * forks the next before it exits.  See bench.sh.
+ */
+
+#include "syscall.h"
+
+#define EXECS 50
+#define FORKS 50
+
+int depth;
+
+void child()
+{
+    depth++;
+    if (depth < FORKS)
+        Fork(child);
+    Exit(depth);
+}
+
+main()
+{
+    int i;
+
+    for (i = 0; i < EXECS; i++)
+        Join(Exec("bench-nop"));
+    Fork(child);
+    Exit(0);
+}
@@ -0,0 +1,27 @@
+/*
+ * bench-stream.c
+ *
+ * Simulator benchmark: sequential loads and stores over an array that
+ * fits in physical memory, so once it has been paged in we measure
+ * the cost of address translation on every access.  See bench.sh.
+ */
+
+#include "syscall.h"
+
+#define WORDS 1024		/* 4KB, half of physical memory */
+#define PASSES 200
+
+int array[WORDS];
+
+main()
+{
+    int i, pass, sum = 0;
+
+    for (pass = 0; pass < PASSES; pass++) {
+        for (i = 0; i < WORDS; i++)
+            array[i] = array[i] + i;
+        for (i = 0; i < WORDS; i++)
+            sum += array[i];
+    }
+    Exit(sum);
+}
@@ -0,0 +1,20 @@
+/*
+ * bench-syscall.c
+ *
+ * Simulator benchmark: a system call ping.  Yield with nobody else to
+ * run goes into the kernel and straight back out, so this measures
+ * the cost of a trap and return.  See bench.sh.
+ */
+
+#include "syscall.h"
+
+#define CALLS 100000
+
+main()
+{
+    int i;
+
+    for (i = 0; i < CALLS; i++)
+        Yield();
+    Exit(0);
+}
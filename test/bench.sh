@@ -0,0 +1,40 @@
+#!/bin/sh
+#
+# bench.sh
+#	Run the simulator benchmarks (bench-*.c, built along with the
+#	other test programs) under ../vm/nachos, and print the results as
+#	CSV: host wall time, simulated ticks, and the rates derived from
+#	them.  Any arguments (e.g. -bb) are passed on to nachos.
+#
+#	Run it before and after a change to the simulator, with
+#	"make bench" in this directory, and compare the rates.
+#
+#	user_ticks is also the number of user instructions executed,
+#	so insns_per_sec is the simulator's instruction rate.
+
+NACHOS=${NACHOS:-../vm/nachos}
+BENCHMARKS="bench-alu bench-stream bench-faults bench-spawn bench-syscall"
+
+echo "benchmark,wall_seconds,total_ticks,user_ticks,system_ticks,page_faults,syscalls,insns_per_sec,ticks_per_sec,faults_per_sec,syscalls_per_sec"
+
+for bench in $BENCHMARKS; do
+    start=$(date +%s.%N)
+    out=$($NACHOS -stats "$@" -x $bench)
+    end=$(date +%s.%N)
+
+    echo "$out" | awk -v bench=$bench -v start=$start -v end=$end '
+	/^Ticks:/ {
+	    total = $3; sys = $7; user = $9
+	    sub(",", "", total); sub(",", "", sys)
+	}
+	/^Paging:/ { faults = $3 }
+	/^System calls:/ { syscalls = $3 }
+	END {
+	    wall = end - start
+	    if (wall <= 0)
+		wall = 0.000001
+	    printf "%s,%.3f,%d,%d,%d,%d,%d,%.0f,%.0f,%.0f,%.0f\n", bench,
+		wall, total, user, sys, faults, syscalls, user / wall,
+		total / wall, faults / wall, syscalls / wall
+	}'
+done
@@ -130,6 +130,30 @@ syscall
 j	$31
 .end Yield
 
+.globl Sbrk
+.ent	Sbrk
+Sbrk:
+addiu $2,$0,SC_Sbrk
+syscall
+j	$31
+.end Sbrk
+
+.globl Mmap
+.ent	Mmap
+Mmap:
+addiu $2,$0,SC_Mmap
+syscall
+j	$31
+.end Mmap
+
+.globl Munmap
+.ent	Munmap
+Munmap:
+addiu $2,$0,SC_Munmap
+syscall
+j	$31
+.end Munmap
+
 /* dummy function to keep gcc happy */
 .globl  __main
 .ent    __main
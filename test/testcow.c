@@ -0,0 +1,65 @@
+#include "syscall.h"
+
+// This test checks that a forked child gets its own copy of its parent's
+// memory, although the two share it copy-on-write until one of them
+// writes.  After the Fork, the parent changes the first half of the
+// array, and the child all of it; each must only ever see its own
+// changes.  The array is bigger than physical memory, so some of the
+// shared pages are in swap when they get copied.
+
+#define SIZE (1024*12)
+
+char buffer[SIZE];
+
+void child();
+
+void print(char *s)
+{
+    int len = 0;
+
+    while (s[len])
+	len++;
+    Write(s, len, ConsoleOutput);
+}
+
+int check(char first, char second)
+{
+    int i;
+
+    for (i = 0; i < SIZE; i++)
+	if (buffer[i] != (i < SIZE / 2 ? first : second))
+	    return 0;
+    return 1;
+}
+
+main()
+{
+    int i;
+
+    for (i = 0; i < SIZE; i++)
+	buffer[i] = 'a';
+    Fork(child);
+    for (i = 0; i < SIZE / 2; i++)
+	buffer[i] = 'p';
+    Yield();			// let the child run
+    if (check('p', 'a'))
+	print("Parent sees its own copy\n");
+    else
+	print("Parent sees the child's writes!\n");
+    Exit(0);
+}
+
+void child()
+{
+    int i;
+
+    if (!check('a', 'a'))
+	print("Child sees the parent's writes!\n");
+    for (i = 0; i < SIZE; i++)
+	buffer[i] = 'c';
+    if (check('c', 'c'))
+	print("Child sees its own copy\n");
+    else
+	print("Child lost its writes!\n");
+    Exit(1);
+}
@@ -0,0 +1,118 @@
+#include "syscall.h"
+
+// This test checks files mapped with Mmap.  It maps a file and reads it
+// through the mapping, changes it and unmaps it, then Reads the file to
+// see that the change was written back.  It maps the file again, Writes
+// to the file, and looks for the new bytes in the mapping.  Finally it
+// forks: the child stores into the mapped page it inherited, and the
+// parent must see the store both through its own mapping and by Read.
+//
+// The file is testmmap.dat, in the directory nachos is run from.
+
+#define PAGE 128
+#define SIZE (2 * PAGE)
+
+char buffer[SIZE];
+char *map;
+
+void child();
+
+void print(char *s)
+{
+    int len = 0;
+
+    while (s[len])
+	len++;
+    Write(s, len, ConsoleOutput);
+}
+
+// does "p" hold "count" bytes of "value", or of the original pattern
+// (the bytes at their own offset "from") if "value" is 0?
+int check(char *p, int from, int count, char value)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+	if (p[i] != (value ? value : 'a' + (from + i) % 26))
+	    return 0;
+    return 1;
+}
+
+// the whole file, as Read sees it now
+char *readFile()
+{
+    OpenFileId id = Open("testmmap.dat");
+
+    if (Read(buffer, SIZE, id) != SIZE)
+	print("Short read!\n");
+    Close(id);
+    return buffer;
+}
+
+main()
+{
+    OpenFileId id;
+    int i;
+
+    for (i = 0; i < SIZE; i++)
+	buffer[i] = 'a' + i % 26;
+    Create("testmmap.dat");
+    id = Open("testmmap.dat");
+    Write(buffer, SIZE, id);
+    Close(id);
+
+    id = Open("testmmap.dat");
+    map = (char *) Mmap(id, 0, SIZE);
+    if ((int) map == -1)
+	print("Mmap failed!\n");
+    else if (check(map, 0, SIZE, 0))
+	print("Mapping reads the file\n");
+    else
+	print("Mapping doesn't match the file!\n");
+
+    // change the first page, and unmap it
+    for (i = 0; i < PAGE; i++)
+	map[i] = 'M';
+    if (Munmap(map) != 0)
+	print("Munmap failed!\n");
+    readFile();
+    if (check(buffer, 0, PAGE, 'M') && check(buffer + PAGE, PAGE, PAGE, 0))
+	print("Munmap wrote the changes back\n");
+    else
+	print("Munmap lost the changes!\n");
+
+    // map it again, and Write to the file underneath
+    map = (char *) Mmap(id, 0, SIZE);
+    id = Open("testmmap.dat");
+    Write("WWWW", 4, id);
+    Close(id);
+    if (check(map, 0, 4, 'W') && check(map + 4, 4, PAGE - 4, 'M'))
+	print("Write seen through the mapping\n");
+    else
+	print("Mapping missed the Write!\n");
+
+    // let a child store into the second page
+    Fork(child);
+    for (i = 0; i < 100 && map[PAGE] != 'C'; i++)
+	Yield();
+    if (check(map + PAGE, PAGE, 4, 'C') && check(map + PAGE + 4, 4, PAGE - 4, 0))
+	print("Parent sees the child's store\n");
+    else
+	print("Parent doesn't see the child's store!\n");
+    readFile();
+    if (check(buffer + PAGE, PAGE, 4, 'C'))
+	print("Read sees the child's store\n");
+    else
+	print("Read doesn't see the child's store!\n");
+    Exit(0);
+}
+
+void child()
+{
+    int i;
+
+    for (i = 0; i < 4; i++)
+	map[PAGE + i] = 'C';
+    print("Child wrote the page\n");
+    Exit(1);
+}
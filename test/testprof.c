@@ -0,0 +1,58 @@
+/*
+ * testprof.c
+ *
+ * Runs a tiny function from every region of the address space: the
+ * code, initialized data, bss, heap, stack and a mapped file.  The
+ * function is two hand-assembled instructions, which don't depend on
+ * where they are.  Run under -prof by testprof.sh, which checks that
+ * the profile counts an instruction in each region.
+ */
+
+#include "syscall.h"
+
+#define PAGE 128		/* PageSize, in machine.h */
+#define JR_RA 0x03e00008	/* jr $ra */
+#define ADDIU_V0_A0_1 0x24820001	/* addiu $v0, $a0, 1 (delay slot) */
+
+typedef int (*Function)(int);
+
+int dataCode[2] = { JR_RA, ADDIU_V0_A0_1 };
+int bssCode[2];
+
+int
+inc(int x)
+{
+    return x + 1;
+}
+
+int
+copyAndRun(int *into, int x)
+{
+    into[0] = JR_RA;
+    into[1] = ADDIU_V0_A0_1;
+    return ((Function) into)(x);
+}
+
+int
+main()
+{
+    int stackCode[2];
+    int sum = 0;
+    OpenFileId id;
+
+    sum += inc(0);
+    sum += ((Function) dataCode)(1);
+    sum += copyAndRun(bssCode, 2);
+    sum += copyAndRun((int *) Sbrk(PAGE), 3);
+    sum += copyAndRun(stackCode, 4);
+
+    Create("testprof.map");
+    id = Open("testprof.map");
+    sum += copyAndRun((int *) Mmap(id, 0, PAGE), 5);
+
+    if (sum == 1 + 2 + 3 + 4 + 5 + 6)
+	Write("Done\n", 5, ConsoleOutput);
+    else
+	Write("Failed\n", 7, ConsoleOutput);
+    Exit(0);
+}
@@ -0,0 +1,33 @@
+#!/bin/sh
+#
+# testprof.sh
+#	Check the execution profile (-prof) on the sparse address space:
+#	run testprof, which executes an instruction in each of its
+#	regions, under ../vm/nachos, and make sure the profile labels one
+#	in each of them, and counts nothing outside the address space.
+#	Any arguments are passed on to nachos.
+
+NACHOS=${NACHOS:-../vm/nachos}
+REGIONS="code data bss heap stack mmap"
+
+rm -f nachos.prof.* testprof.map
+out=$($NACHOS -prof "$@" -x testprof)
+status=0
+
+if ! echo "$out" | grep -q "^$(cat testprof.expected)\$"; then
+    echo "testprof: testprof didn't print $(cat testprof.expected)"
+    status=1
+fi
+for region in $REGIONS; do
+    if ! grep -q "^0x[0-9a-f]* $region+0x" nachos.prof.*; then
+	echo "testprof: nothing profiled in the $region"
+	status=1
+    fi
+done
+if grep -q "outside the address space" nachos.prof.*; then
+    echo "testprof: instructions profiled outside the address space"
+    status=1
+fi
+rm -f testprof.map
+[ $status = 0 ] && echo "testprof: ok"
+exit $status
@@ -0,0 +1,83 @@
+#include "syscall.h"
+
+// This test checks the heap and the stack, which both grow as they are
+// used.  It grows the heap with Sbrk, writes and reads it back, gives
+// part of it back and grows it again (the pages that come back must be
+// zeroed), and makes sure the heap can't grow into the stack.  Then it
+// recurses deep enough for the stack to grow well past UserStackSize.
+
+#define PAGE 128
+#define HEAP (20 * PAGE)
+#define DEPTH 40		// frames of over a page each: some 6KB of stack
+
+void print(char *s)
+{
+    int len = 0;
+
+    while (s[len])
+	len++;
+    Write(s, len, ConsoleOutput);
+}
+
+int check(char *p, int size, int value)
+{
+    int i;
+
+    for (i = 0; i < size; i++)
+	if (p[i] != (char) (value == -1 ? i : value))
+	    return 0;
+    return 1;
+}
+
+// fill a frame bigger than a page, so each call touches a new one
+int recurse(int depth)
+{
+    char frame[PAGE + 8];
+    int i, sum;
+
+    for (i = 0; i < PAGE + 8; i++)
+	frame[i] = depth;
+    sum = (depth == 0) ? 0 : recurse(depth - 1);
+    for (i = 0; i < PAGE + 8; i++)
+	if (frame[i] != (char) depth)
+	    return -1000;
+    return sum + depth;
+}
+
+main()
+{
+    char *heap;
+    int i;
+
+    heap = (char *) Sbrk(HEAP);
+    if ((int) heap == -1)
+	print("Sbrk failed!\n");
+    if (!check(heap, HEAP, 0))
+	print("New heap isn't zeroed!\n");
+    for (i = 0; i < HEAP; i++)
+	heap[i] = i;
+    if (check(heap, HEAP, -1))
+	print("Heap grown\n");
+    else
+	print("Heap lost its contents!\n");
+
+    // give back the top half, then grow over it again
+    Sbrk(-HEAP / 2);
+    if ((char *) Sbrk(HEAP / 2) != heap + HEAP / 2)
+	print("Sbrk returned the wrong break!\n");
+    if (check(heap, HEAP / 2, -1) && check(heap + HEAP / 2, HEAP / 2, 0))
+	print("Heap shrunk and zeroed\n");
+    else
+	print("Heap wasn't shrunk!\n");
+
+    if ((int) Sbrk(1 << 20) == -1 && (int) Sbrk(-(1 << 20)) == -1)
+	print("Heap kept out of the stack\n");
+    else
+	print("Sbrk went too far!\n");
+
+    if (recurse(DEPTH) == DEPTH * (DEPTH + 1) / 2)
+	print("Stack grown\n");
+    else
+	print("Stack lost its contents!\n");
+    Exit(0);
+}
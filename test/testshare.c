@@ -0,0 +1,25 @@
+#include "syscall.h"
+
+// This test runs several copies of testvm1 at once, so that they share
+// its program text.  The second copy starts while the first is still
+// running, and the third once the first has gone, so the shared text
+// has to outlive the process that read it in.  Each copy fills its own
+// data, which must not be shared, and checks it.
+
+// Note: this test should be called from code/vm, because the filename
+// is dependent on that;
+
+int
+main()
+{
+    int id1, id2, id3;
+
+    id1 = Exec("../test/testvm1");
+    id2 = Exec("../test/testvm1");
+    Join(id1);
+    id3 = Exec("../test/testvm1");
+    Join(id2);
+    Join(id3);
+    Write("Done\n", 5, ConsoleOutput);
+    Exit(0);
+}
@@ -0,0 +1,73 @@
+#include "syscall.h"
+
+// This test is meant to be run with a small software-loaded TLB, as in
+// "nachos -tlb 4 -x ../test/testtlb".  It touches many more pages than
+// the TLB holds, over and over, so entries are constantly replaced.
+// Then it forks: parent and child write different values to the same
+// virtual pages and switch back and forth, so that a TLB entry left over
+// from one address space must never be used for the other.
+
+#define PAGE 128
+#define PAGES 40
+
+char buffer[PAGES * PAGE];
+
+void child();
+
+void print(char *s)
+{
+    int len = 0;
+
+    while (s[len])
+	len++;
+    Write(s, len, ConsoleOutput);
+}
+
+void fill(int value)
+{
+    int i;
+
+    for (i = 0; i < PAGES; i++)
+	buffer[i * PAGE] = value + i;
+}
+
+// check every page, several times round; yield between rounds, so the
+// other process gets to run with the same virtual pages
+int check(int value)
+{
+    int round, i;
+
+    for (round = 0; round < 4; round++) {
+	for (i = 0; i < PAGES; i++)
+	    if (buffer[i * PAGE] != (char) (value + i))
+		return 0;
+	Yield();
+    }
+    return 1;
+}
+
+main()
+{
+    fill(0);
+    if (check(0))
+	print("Pages kept\n");
+    else
+	print("Pages lost!\n");
+    Fork(child);
+    fill(100);
+    if (check(100))
+	print("Parent sees its own pages\n");
+    else
+	print("Parent sees the child's pages!\n");
+    Exit(0);
+}
+
+void child()
+{
+    fill(50);
+    if (check(50))
+	print("Child sees its own pages\n");
+    else
+	print("Child sees the parent's pages!\n");
+    Exit(1);
+}
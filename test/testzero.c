@@ -0,0 +1,65 @@
+#include "syscall.h"
+
+// This test checks the pages that start out zero-filled: the stack and
+// the bss, which is bigger than physical memory.  Then it writes to
+// every other page of the bss, and checks that those pages keep what was
+// written, and the others stay zero, after they have all been evicted.
+
+#define PAGE 128		/* PageSize, in machine.h */
+#define SIZE (PAGE * 96)	/* more than NumPhysPages */
+
+char bss[SIZE];
+
+void print(char *s)
+{
+    int len = 0;
+
+    while (s[len])
+	len++;
+    Write(s, len, ConsoleOutput);
+}
+
+int stackIsZero()
+{
+    char local[4 * PAGE];	// below anything used so far
+    int i;
+
+    for (i = 0; i < 4 * PAGE; i++)
+	if (local[i] != 0)
+	    return 0;
+    return 1;
+}
+
+// Whether every page of the bss holds what it should: zero, or the page
+// number if it is an odd one and "written"
+int bssIsRight(int written)
+{
+    int i;
+
+    for (i = 0; i < SIZE; i++)
+	if (bss[i] != ((written && (i / PAGE) % 2 == 1) ? (char) (i / PAGE) : 0))
+	    return 0;
+    return 1;
+}
+
+main()
+{
+    int i;
+
+    if (stackIsZero())
+	print("Stack zero-filled\n");
+    else
+	print("Stack not zero-filled!\n");
+    if (bssIsRight(0))
+	print("Bss zero-filled\n");
+    else
+	print("Bss not zero-filled!\n");
+    for (i = 0; i < SIZE; i++)
+	if ((i / PAGE) % 2 == 1)
+	    bss[i] = (char) (i / PAGE);
+    if (bssIsRight(1))
+	print("Bss kept\n");
+    else
+	print("Bss lost!\n");
+    Exit(0);
+}
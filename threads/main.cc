@@ -8,8 +8,10 @@
 //
 // 	Most of this file is not needed until later assignments.
 //
-// Usage: nachos -d <debugflags> -rs <random seed #>
-//		-s -x <nachos file> -c <consoleIn> <consoleOut>
+// Usage: nachos -d <debugflags> -rs <random seed #> -stats
+//		-s -bb -prof -x <nachos file> -c <consoleIn> <consoleOut>
+//		-ckpt <image file> <tick> -restore <image file> -vm <policy>
+//		-vmstats <file> -dedup -tlb <entries> -tlbpolicy <policy>
 //		-f -cp <unix file> <nachos file>
 //		-p <nachos file> -r <nachos file> -l -D -t
 //              -n <network reliability> -m <machine id>
@@ -18,13 +20,33 @@
 //
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -stats prints the performance statistics when the machine halts
 //    -z prints the copyright message
 //
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
+//    -bb runs user programs with the basic-block (threaded code) engine
+//    -prof writes an execution profile of each user process to
+//	"nachos.prof.<pid>" when it exits (or halts the machine)
 //    -x runs a user program
 //    -c tests the console
 //
+//  VM
+//    -ckpt saves the user program to an image file, at its first trap
+//	from user code at or after the given tick (see checkpoint.h)
+//    -restore runs a user program from an image saved with -ckpt
+//    -vm picks the page replacement policy: clock (the default),
+//	wsclock, aging or 2q (see replacement.h)
+//    -vmstats writes the paging statistics of each process, and their
+//	totals, to a file as comma separated values when the machine halts
+//	(see PagingStatistics in stats.h)
+//    -dedup runs a kernel thread that merges frames holding identical
+//	pages into one, shared copy-on-write
+//    -tlb runs user programs with a software-loaded TLB of the given
+//	number of entries, instead of page tables (see tlbmanager.h)
+//    -tlbpolicy picks the TLB replacement policy: clock (the default),
+//	fifo or random
+//
 //  FILESYS
 //    -f causes the physical disk to be formatted
 //    -cp copies a file from UNIX to Nachos
@@ -69,6 +91,9 @@ extern void Copy(char *unixFile, char *nachosFile);
 extern void Print(char *file), PerformanceTest(void);
 extern void StartProcess(char *file), ConsoleTest(char *in, char *out);
 extern void MailTest(int networkID);
+#ifdef VM
+extern void RestoreProcess(char *image);
+#endif
 
 //----------------------------------------------------------------------
 // main
@@ -152,6 +177,12 @@ main(int argc, char **argv)
 	    ASSERT(argc > 1);
             StartProcess(*(argv + 1));
             argCount = 2;
+#ifdef VM
+        } else if (!strcmp(*argv, "-restore")) {  // resume a checkpoint
+	    ASSERT(argc > 1);
+            RestoreProcess(*(argv + 1));
+            argCount = 2;
+#endif
         } else if (!strcmp(*argv, "-c")) {      // test the console
 	    if (argc == 1)
 	        ConsoleTest(NULL, NULL);
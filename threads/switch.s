@@ -300,13 +300,22 @@ ldw  S15(%arg1), %r18
                                                **      edx     contains inital argument to thread function
                                                **      esi     points to thread function
                                                **      edi     point to Thread::Finish()
+                                               **
+                                               ** gcc -O2 assumes the stack is 16-byte aligned at every call, and
+                                               ** lets a function scribble on its own arguments, so we align the
+                                               ** stack ourselves and keep the argument in ebx (which is preserved
+                                               ** across calls) rather than reusing one pushed copy for every call.
                                                */
                                                ThreadRoot:
                                                pushl   %ebp
                                                movl    %esp,%ebp
-                                               pushl   InitialArg
+                                               movl    InitialArg,%ebx
+                                               andl    $-16,%esp
                                                call    *StartupPC
+                                               subl    $12,%esp
+                                               pushl   %ebx
                                                call    *InitialPC
+                                               addl    $16,%esp
                                                call    *WhenDonePC
 
                                                /* NOT REACHED*/
@@ -19,6 +19,7 @@ Interrupt *interrupt;			// interrupt status
 Statistics *stats;			// performance metrics
 Timer *timer;				// the hardware timer device,
 					// for invoking context switches
+bool printStats;			// print the statistics on halt (-stats)
 
 #ifdef FILESYS_NEEDED
 FileSystem  *fileSystem;
@@ -30,6 +31,8 @@ SynchDisk   *synchDisk;
 
 #ifdef USER_PROGRAM	// requires either FILESYS or FILESYS_STUB
 Machine *machine;	// user program memory and registers
+bool profileUserPrograms;	// collect an execution profile for
+				// each user process (-prof)
 Lock* machineLock;
 
 char diskBuffer[PageSize]; // PageSize defined in machine.h
@@ -48,7 +51,12 @@ Lock* fileManagerLock;
 
 #ifdef VM
 VirtualMemoryManager *virtualMemoryManager;
+TLBManager *tlbManager;
 Lock* virtMemManagerLock;
+char *checkpointImage;		// where to save a checkpoint (-ckpt),
+int checkpointTick;		// and from when on; NULL if none
+char *vmStatsFile;		// where to write the paging statistics
+				// (-vmstats), or NULL
 #endif // VM
 
 #ifdef NETWORK
@@ -101,6 +109,13 @@ Initialize(int argc, char **argv)
 
 #ifdef USER_PROGRAM
     bool debugUserProg = FALSE;	// single step user program
+    bool runBlocks = FALSE;	// use the basic-block engine
+    int tlbEntries = 0;		// size of the TLB; 0 to use page tables
+#endif
+#ifdef VM
+    char *replacementPolicy = "clock";	// page replacement policy
+    bool dedup = FALSE;			// merge identical pages
+    char *tlbPolicy = "clock";		// TLB replacement policy
 #endif
 #ifdef FILESYS_NEEDED
     bool format = FALSE;	// format disk
@@ -125,10 +140,43 @@ Initialize(int argc, char **argv)
 						// number generator
 	    randomYield = TRUE;
 	    argCount = 2;
+	} else if (!strcmp(*argv, "-stats")) {
+	    printStats = TRUE;
 	}
 #ifdef USER_PROGRAM
 	if (!strcmp(*argv, "-s"))
 	    debugUserProg = TRUE;
+	if (!strcmp(*argv, "-bb"))
+	    runBlocks = TRUE;
+	if (!strcmp(*argv, "-prof"))
+	    profileUserPrograms = TRUE;
+#endif
+#ifdef VM
+	if (!strcmp(*argv, "-ckpt")) {
+	    ASSERT(argc > 2);
+	    checkpointImage = *(argv + 1);
+	    checkpointTick = atoi(*(argv + 2));
+	    argCount = 3;
+	} else if (!strcmp(*argv, "-vm")) {
+	    ASSERT(argc > 1);
+	    replacementPolicy = *(argv + 1);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-dedup")) {
+	    dedup = TRUE;
+	} else if (!strcmp(*argv, "-vmstats")) {
+	    ASSERT(argc > 1);
+	    vmStatsFile = *(argv + 1);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-tlb")) {
+	    ASSERT(argc > 1);
+	    tlbEntries = atoi(*(argv + 1));
+	    ASSERT(tlbEntries > 0);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-tlbpolicy")) {
+	    ASSERT(argc > 1);
+	    tlbPolicy = *(argv + 1);
+	    argCount = 2;
+	}
 #endif
 #ifdef FILESYS_NEEDED
 	if (!strcmp(*argv, "-f"))
@@ -166,7 +214,7 @@ Initialize(int argc, char **argv)
     CallOnUserAbort(Cleanup);			// if user hits ctl-C
     
 #ifdef USER_PROGRAM
-    machine = new Machine(debugUserProg);	// this must come first
+    machine = new Machine(debugUserProg, runBlocks, tlbEntries);	// this must come first
     machineLock = new Lock("machineLock");
 
     memoryManager = new MemoryManager();
@@ -183,8 +231,12 @@ Initialize(int argc, char **argv)
 #endif // USER_PROGRAM
 
 #ifdef VM
-virtualMemoryManager = new VirtualMemoryManager();
+virtualMemoryManager = new VirtualMemoryManager(replacementPolicy);
 virtMemManagerLock = new Lock("virtMemManagerLock");
+virtualMemoryManager->startPageOutDaemon();
+if (dedup)
+    virtualMemoryManager->startDedupScanner();
+tlbManager = machine->tlb != NULL ? new TLBManager(tlbPolicy) : NULL;
 #endif // VM
 
 #ifdef FILESYS
@@ -230,7 +282,15 @@ Cleanup()
 #endif // USER_PROGRAM
 
 #ifdef VM
+if (printStats) {
+    virtualMemoryManager->Print();
+    if (tlbManager != NULL)
+        tlbManager->Print();
+}
+if (vmStatsFile != NULL)
+    virtualMemoryManager->exportStats(vmStatsFile);
 delete virtualMemoryManager;
+delete tlbManager;
 delete virtMemManagerLock;
 #endif
 
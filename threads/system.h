@@ -28,6 +28,7 @@ extern Scheduler *scheduler;			// the ready list
 extern Interrupt *interrupt;			// interrupt status
 extern Statistics *stats;			// performance metrics
 extern Timer *timer;				// the hardware alarm clock
+extern bool printStats;				// -stats: print stats on halt
 
 #ifdef USER_PROGRAM
 
@@ -38,6 +39,7 @@ extern Timer *timer;				// the hardware alarm clock
 #include "openfilemanager.h"
 
 extern Machine* machine;	// user program memory and registers
+extern bool profileUserPrograms;	// -prof: profile user processes
 extern Lock* machineLock;
 
 extern char diskBuffer[PageSize]; // PageSize defined in machine.h
@@ -57,7 +59,15 @@ extern Lock* fileManagerLock;
 #ifdef VM
 #include "virtualmemorymanager.h"
 extern VirtualMemoryManager*virtualMemoryManager;
+#include "tlbmanager.h"
+extern TLBManager *tlbManager;		// -tlb: loads the TLB; NULL if we
+					// use page tables
 extern Lock* virtMemManagerLock;
+extern char *checkpointImage;		// -ckpt: image to save, or NULL
+extern int checkpointTick;		// -ckpt: save at the first trap
+					// from this tick on
+extern char *vmStatsFile;		// -vmstats: file for the paging
+					// statistics, or NULL
 #endif
 
 #ifdef FILESYS_NEEDED		// FILESYS or FILESYS_STUB 
@@ -266,6 +266,8 @@ Thread::StackAllocate (VoidFunctionPtr func, int arg)
 #else  // HOST_MIPS  || HOST_i386
     stackTop = stack + StackSize - 4;	// -4 to be on the safe side!
 #ifdef HOST_i386
+    // start on a 16-byte boundary, as code compiled with -O2 expects
+    stackTop = (int *) ((unsigned int) stackTop & ~15);
     // the 80386 passes the return address on the stack.  In order for
     // SWITCH() to go to ThreadRoot when we switch to this thread, the
     // return addres used in SWITCH() must be the starting address of
@@ -40,6 +40,7 @@ DebugInit(char *flagList)
     enableFlags = flagList;
 }
 
+#ifndef NO_DEBUG
 //----------------------------------------------------------------------
 // DebugIsEnabled
 //      Return TRUE if DEBUG messages with "flag" are to be printed.
@@ -73,3 +74,4 @@ DEBUG(char flag, char *format, ...)
 	fflush(stdout);
     }
 }
+#endif // NO_DEBUG
@@ -60,10 +60,20 @@ typedef void (*VoidNoArgFunctionPtr)();
 
 extern void DebugInit(char* flags);	// enable printing debug messages
 
+#ifdef NO_DEBUG
+// Release build ("make release"): nothing is tested or printed, so
+// tracing costs next to nothing in the simulator's inner loops.  DEBUG
+// is an empty inline function rather than an empty macro, so that the
+// variables computed only to be printed are still used; its arguments
+// are evaluated, then, but they are cheap.
+#define DebugIsEnabled(flag)	FALSE
+inline void DEBUG(char flag, const char *format, ...) {}
+#else
 extern bool DebugIsEnabled(char flag); 	// Is this debug flag enabled?
 
 extern void DEBUG (char flag, char* format, ...);  	// Print debug message 
 							// if flag is enabled
+#endif
 
 //----------------------------------------------------------------------
 // ASSERT
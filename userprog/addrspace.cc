@@ -21,6 +21,10 @@
 #include "noff.h"
 #include "machine.h" // definition of PageSize
 #include "virtualmemorymanager.h"
+#include "profile.h"
+#include "execfile.h"
+#include "sysopenfile.h"
+#include "list.h"
 
 #ifdef HOST_SPARC
 #include <strings.h>
@@ -51,131 +55,145 @@ SwapHeader (NoffHeader *noffH)
 //----------------------------------------------------------------------
 // AddrSpace::AddrSpace
 // 	Create an address space to run a user program.
-//	Load the program from a file "executable", and set everything
+//	Load the program from a file "execFile", and set everything
 //	up so that we can start executing user instructions.
 //
 //	Assumes that the object code file is in NOFF format.
 //
-//	First, set up the translation from program memory to physical 
-//	memory.  For now, this is really simple (1:1), since we are
-//	only uniprogramming, and we have a single unsegmented page table
+//	The program goes at the bottom of the address space, and the
+//	stack at the top (see addrspace.h); the page table starts out
+//	empty, and its second-level tables are allocated as the pages
+//	they cover are touched.
 //
-//	"executable" is the file containing the object code to load into memory
+//	"execFile" is the file containing the object code to load into memory
+//	"fileName" is the name it was opened by
+//
+//	Nothing is read in yet: the address space keeps "execFile"
+//	open (and closes it when it goes away), and pages are filled
+//	in from it as they are first touched (see fillPage).  If another
+//	process is already running "fileName", we use its ExecFile
+//	instead, so the two can share their program text.
 //----------------------------------------------------------------------
 
-AddrSpace::AddrSpace(OpenFile *executable, PCB* newPCB)
+AddrSpace::AddrSpace(OpenFile *execFile, PCB* newPCB, char *fileName)
 {
     NoffHeader noffH;
-    unsigned int i, size;
+    unsigned int size;
 
-    executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
+    execFile->ReadAt((char *)&noffH, sizeof(noffH), 0);
     if ((noffH.noffMagic != NOFFMAGIC) && 
 		(WordToHost(noffH.noffMagic) == NOFFMAGIC))
         SwapHeader(&noffH);
     ASSERT(noffH.noffMagic == NOFFMAGIC);
 
-    // how big is address space?
-    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size 
-			+ UserStackSize;	// we need to increase the size
-						// to leave room for the stack
-    numPages = divRoundUp(size, PageSize);
-    size = numPages * PageSize;
+    // how big is the program?  The stack is at the other end
+    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size;
+    numPages = UserAddrSpaceSize / PageSize;
+    heapStart = heapEnd = divRoundUp(size, PageSize);
+    heapBreak = heapEnd * PageSize;
+    stackStart = numPages - divRoundUp(UserStackSize, PageSize);
+    ASSERT(heapEnd <= stackStart);
 
-    DEBUG('a', "Initializing address space, num pages %d, size %d\n", numPages, size);
+    DEBUG('a', "Initializing address space, %d pages of program, %d of stack\n",
+          heapEnd, numPages - stackStart);
 
     this->pcb = newPCB;
-
-    pageTable = new TranslationEntry[numPages];
-    locationOnDisk = new int[numPages];
-    for (i = 0; i < numPages; i++) {
-
-        // Set the usual bits for a new process
-        pageTable[i].virtualPage = i;
-        pageTable[i].physicalPage = -1; // demand paging
-        pageTable[i].valid = FALSE;
-        pageTable[i].use = FALSE;
-        pageTable[i].dirty = FALSE;
-        pageTable[i].readOnly = FALSE;
-
-        // Allocate space for entire addr space on backing store at creation
-        //pageTable[i].space = this;
-        int l = virtualMemoryManager->allocSwapSector();
-      //  pageTable[i].locationOnDisk = l
-        locationOnDisk[i] = l;
-
-        char placeHolder[PageSize];
-        bzero(placeHolder, PageSize);
-        virtualMemoryManager->writeToSwap(placeHolder, PageSize, l);
-
-        // Debuggin output
-        int currVirtPage = l / PageSize;
-        DEBUG('v',"Z %d: %d\n", pcb->getPID(), currVirtPage);
-
-        // Maintain swap space page information
-        //SwapSectorInfo * swapInfo =
-        //        virtualMemoryManager->getSwapSectorInfo(pageTable[i].locationOnDisk / PageSize);
-        //swapInfo->pageTableEntry = &pageTable[i];
-
-
-    }
+    profile = NULL;
+    nextSequentialFault = -1;
+    readAheadWindow = 0;
+    asid = -1;
+    if (profileUserPrograms)
+        profile = new Profile(&noffH, numPages * PageSize, pcb->getPID());
+    executable = ExecFile::Find(fileName);
+    if (executable != NULL) {
+        executable->Share();
+        delete execFile;
+    } else
+        executable = new ExecFile(fileName, execFile, &noffH);
+    initPageTable();
+    mappings = new List;
 
     //printf("Loaded Program: %d code | %d data | %d bss\n",
     DEBUG('v',"Loaded Program: %d code | %d data | %d bss\n",
         noffH.code.size, noffH.initData.size, noffH.uninitData.size);
-
-    // then, copy in the code and data segments into memory using new
-    // ReadFile functionality
-    if (noffH.code.size > 0) {
-        DEBUG('a', "Initializing code segment, at 0x%x, size %d\n", 
-            noffH.code.virtualAddr, noffH.code.size);
-
-        ReadFile(noffH.code.virtualAddr,executable,noffH.code.size,
-            noffH.code.inFileAddr);
-    }
-    if (noffH.initData.size > 0) {
-        DEBUG('a', "Initializing data segment, at 0x%x, size %d\n", 
-            noffH.initData.virtualAddr, noffH.initData.size);
-        ReadFile(noffH.initData.virtualAddr,executable,
-            noffH.initData.size,noffH.initData.inFileAddr);
-    }
+    if (isValid())
+        virtualMemoryManager->addAddrSpace(this);
 }
 
 //----------------------------------------------------------------------
 // AddrSpace::AddrSpace
 //     Copy constructor that makes an identical copy of this address space.
+//
+//     Nothing is actually copied: the new space shares the other's
+//     frames and swap sectors copy-on-write, and a page is only copied
+//     when one of the two first writes to it (see
+//     VirtualMemoryManager::copyOnWrite).
 //----------------------------------------------------------------------
 
 AddrSpace::AddrSpace(const AddrSpace* other, PCB* newPCB)
 {
     // Copy all page table entries over, create associated PCB
     numPages = other->numPages;
+    heapStart = other->heapStart;
+    heapBreak = other->heapBreak;
+    heapEnd = other->heapEnd;
+    stackStart = other->stackStart;
     DEBUG('a', "Initializing address space with num pages: %d.\n", numPages);
 
     this->pcb = newPCB;
-    pageTable = new TranslationEntry[numPages];
-    locationOnDisk = new int[numPages];
-
-    for (unsigned int i = 0; i < numPages; i++) { 
-
-        pageTable[i].virtualPage = i;
-        pageTable[i].physicalPage = -1;
-        pageTable[i].valid = FALSE;
-        pageTable[i].use = FALSE;
-        pageTable[i].dirty = FALSE;
-        pageTable[i].readOnly = FALSE;
-
-        // Allocate space for entire addr space on backing store at creation
-        //pageTable[i].space = this;
-        int l = virtualMemoryManager->allocSwapSector();
-        locationOnDisk[i] = l;
-        virtualMemoryManager->copySwapSector(l,
-                                             other->locationOnDisk[i]);
-        
-        // Maintain swap space page information
-        //SwapSectorInfo * swapInfo =
-        //       virtualMemoryManager->getSwapSectorInfo(pageTable[i].locationOnDisk / PageSize);
-        //swapInfo->pageTableEntry = &pageTable[i];
+    profile = NULL;
+    nextSequentialFault = -1;
+    readAheadWindow = 0;
+    asid = -1;
+    if (other->profile != NULL)
+        profile = new Profile(other->profile, pcb->getPID());
+    executable = NULL;
+    if (other->executable != NULL)
+        executable = other->executable->Share();
+    initPageTable();
+
+    // The child maps the same files; the pages stay shared
+    mappings = new List;
+    for (int i = 0; i < other->mappings->GetSize(); i++) {
+        MemoryMapping* mapping = new MemoryMapping;
+        *mapping = *(MemoryMapping*) other->mappings->GetElementAt(i);
+        mapping->file->numProcessesAccessing++;
+        mappings->Append(mapping);
     }
+    virtualMemoryManager->shareAddrSpace((AddrSpace*) other, this);
+    if (isValid())
+        virtualMemoryManager->addAddrSpace(this);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::AddrSpace
+//     Create an address space with nothing in it -- no resident pages
+//     and no swap space -- whose program and heap end at page "heap",
+//     and whose stack starts at page "stack".  The caller fills in the
+//     page table and swap locations, and where the heap starts (see
+//     RestoreProcess in checkpoint.cc).
+//----------------------------------------------------------------------
+
+AddrSpace::AddrSpace(int heap, int stack, PCB* newPCB)
+{
+    numPages = UserAddrSpaceSize / PageSize;
+    heapStart = heapEnd = heap;
+    heapBreak = heapEnd * PageSize;
+    stackStart = stack;
+    ASSERT(heapEnd <= stackStart && stackStart <= (int) numPages);
+    DEBUG('a', "Initializing empty address space, %d pages of program, "
+          "%d of stack\n", heapEnd, numPages - stackStart);
+
+    this->pcb = newPCB;
+    profile = NULL;
+    nextSequentialFault = -1;
+    readAheadWindow = 0;
+    asid = -1;
+    executable = NULL;
+    initPageTable();
+    mappings = new List;
+    if (isValid())
+        virtualMemoryManager->addAddrSpace(this);
 }
 
 //----------------------------------------------------------------------
@@ -186,12 +204,29 @@ AddrSpace::AddrSpace(const AddrSpace* other, PCB* newPCB)
 
 AddrSpace::~AddrSpace()
 {
+    if (profile != NULL) {
+        ReportProfile();
+        if (machine->profile == profile)
+            machine->profile = NULL;
+        delete profile;
+    }
     if (isValid()) 
     {
         virtualMemoryManager->releasePages(this);
-        delete [] pageTable;
         delete pcb;
     }
+    while (!mappings->IsEmpty()) {
+        MemoryMapping* mapping = (MemoryMapping*) mappings->Remove();
+        mapping->file->closedBySingleProcess();
+        delete mapping;
+    }
+    delete mappings;
+    for (int i = 0; i < numTables; i++)
+        delete [] pageDirectory[i];
+    delete [] pageDirectory;
+    delete [] swapExtents;
+    if (executable != NULL)
+        executable->Release();
 }
 
 //----------------------------------------------------------------------
@@ -220,8 +255,8 @@ AddrSpace::InitRegisters()
     // of branch delay possibility
     machine->WriteRegister(NextPCReg, 4);
 
-   // Set the stack register to the end of the address space, where we
-   // allocated the stack; but subtract off a bit, to make sure we don't
+   // Set the stack register to the top of the address space, where
+   // the stack is; but subtract off a bit, to make sure we don't
    // accidentally reference off the end!
     machine->WriteRegister(StackReg, numPages * PageSize - 16);
     machineLock->Release();
@@ -244,13 +279,34 @@ void AddrSpace::SaveState()
 // 	On a context switch, restore the machine state so that
 //	this address space can run.
 //
-//      For now, tell the machine where to find the page table.
+//      For now, tell the machine where to find the page table, and
+//	forget any translations cached for the previous address space.
+//	With a TLB, just tell it which entries are ours; those of the
+//	previous address space can stay.
 //----------------------------------------------------------------------
 
 void AddrSpace::RestoreState() 
 {
-    machine->pageTable = pageTable;
+    machine->profile = profile;
+    if (machine->tlb != NULL) {
+        machine->currentASID = asid;
+        return;
+    }
+    machine->pageDirectory = pageDirectory;
     machine->pageTableSize = numPages;
+    machine->FlushSoftTLB();
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ReportProfile
+// 	Write out the execution profile of this process, if we are
+//	keeping one (see profile.h).
+//----------------------------------------------------------------------
+
+void AddrSpace::ReportProfile()
+{
+    if (profile != NULL)
+        profile->Report(this);
 }
 
 //----------------------------------------------------------------------
@@ -267,17 +323,19 @@ int AddrSpace::Translate(int virtualAddress)
     unsigned int pageTableIndex = (unsigned int) virtualAddress / PageSize;
     int offset = virtualAddress % PageSize;
     int physicalAddress = 0;
+    TranslationEntry* table;
 
     if (pageTableIndex >= numPages) {
         fprintf(stderr,"Page table index: %d bigger than num pages: %d.\n", pageTableIndex, numPages);
         return -1;
     } 
-    else if (!pageTable[pageTableIndex].valid) {
+    table = pageDirectory[pageTableIndex / PageTableSpan];
+    if (table == NULL || !table[pageTableIndex % PageTableSpan].valid) {
         fprintf(stderr,"Page table index %d is not valid.\n", pageTableIndex);
         return -1;
     }
 
-    int frame = pageTable[pageTableIndex].physicalPage;
+    int frame = table[pageTableIndex % PageTableSpan].physicalPage;
 
     if (frame >= NumPhysPages) {
         fprintf(stderr,"The calculated frame %d larger than num phys pages %d.\n", frame, NumPhysPages);
@@ -290,31 +348,18 @@ int AddrSpace::Translate(int virtualAddress)
 }
 
 //----------------------------------------------------------------------
-// AddrSpace::ReadFile
-//     
-//     Loads the code and data segments into the translated memory.
+// AddrSpace::fillPage
+//     Fill in "into" with the contents of page "pageTableIndex", which
+//     has never been written to swap: what the executable loaded into
+//     it, or zeroes.  Returns FALSE if it was zero-filled.
 //----------------------------------------------------------------------
 
-int AddrSpace::ReadFile(int virtAddr, OpenFile* file, int size, int fileAddr)
+bool AddrSpace::fillPage(int pageTableIndex, char* into)
 {
-    char buffer1[size];
-    int numBytesTotal = file->ReadAt(buffer1, size, fileAddr);
-    size = numBytesTotal;
-    int bytesCopiedSoFar = 0;
-
-    while (size > 0) { // we have remaining bytes to read
-
-        int pageTableIndex = virtAddr / PageSize;
-        int offset = virtAddr % PageSize;
-        int numBytesThisLoop = size < PageSize ? size : PageSize; // read 1 page at a time
-        virtualMemoryManager->writeToSwap(buffer1 + bytesCopiedSoFar, numBytesThisLoop,
-                                        locationOnDisk[pageTableIndex] + offset);
-        size -= numBytesThisLoop;
-        bytesCopiedSoFar += numBytesThisLoop;
-        virtAddr += numBytesThisLoop;
-    }
-
-    return numBytesTotal;
+    if (executable != NULL)
+        return executable->ReadPage(pageTableIndex, into);
+    bzero(into, PageSize);
+    return FALSE;
 }
 
 //----------------------------------------------------------------------
@@ -337,15 +382,253 @@ bool AddrSpace::isValid()
     return (this->pcb != NULL);
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::isLegalPage
+//     Is page "pageTableIndex" part of the address space: the program
+//     and heap at the bottom, the stack at the top, or a mapped file?
+//     Nothing else is.
+//----------------------------------------------------------------------
+
+bool AddrSpace::isLegalPage(int pageTableIndex)
+{
+    return (pageTableIndex >= 0 && pageTableIndex < heapEnd) ||
+        (pageTableIndex >= stackStart && pageTableIndex < (int) numPages) ||
+        findMapping(pageTableIndex) != NULL;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::sbrk
+//     Move the end of the heap by "increment" bytes (which may be
+//     negative), and return where it was, or -1 if that would take it
+//     below the start of the heap, or into the stack or a mapped file.
+//
+//     Nothing is allocated for new heap pages; they are zero-filled
+//     when first touched.  The pages given back are dropped, along
+//     with their swap sectors, so they come back zeroed too.
+//----------------------------------------------------------------------
+
+int AddrSpace::sbrk(int increment)
+{
+    int oldBreak = heapBreak;
+    int newEnd;
+
+    if (increment < heapStart * PageSize - heapBreak ||
+        increment > heapLimit() * PageSize - heapBreak)
+        return -1;
+    newEnd = divRoundUp(heapBreak + increment, PageSize);
+
+    if (newEnd < heapEnd)
+        virtualMemoryManager->discardPages(this, newEnd, heapEnd - newEnd);
+    heapEnd = newEnd;
+    heapBreak += increment;
+    DEBUG('a', "Heap break moved from 0x%x to 0x%x\n", oldBreak, heapBreak);
+    return oldBreak;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::growStack
+//     A page fault at "virtAddr" outside the address space: if it's on
+//     the way down from the stack, i.e. no more than a page below
+//     "stackPointer", and the stack wouldn't get bigger than
+//     MaxStackSize or run into the heap, make the stack reach down to
+//     it, and return TRUE.
+//----------------------------------------------------------------------
+
+bool AddrSpace::growStack(int virtAddr, int stackPointer)
+{
+    int page = virtAddr / PageSize;
+
+    if (virtAddr < 0 || virtAddr < stackPointer - PageSize ||
+        page >= stackStart || page < heapEnd ||
+        ((int) numPages - page) * PageSize > MaxStackSize)
+        return FALSE;
+
+    DEBUG('a', "Stack grown from page %d down to %d\n", stackStart, page);
+    stackStart = page;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::mmap
+//     Map "length" bytes of "file", from "offset" (which must be at the
+//     start of a page) on, into the address space, and return where
+//     they are, or -1 if there's no room.
+//
+//     Nothing is read yet: each page is brought in from the file when
+//     it is first touched, and written back to it when it is evicted
+//     or unmapped.  Mapping past the end of the file is allowed; those
+//     bytes read as zeroes, and aren't written back.  The file is kept
+//     open until it is unmapped.
+//----------------------------------------------------------------------
+
+int AddrSpace::mmap(SysOpenFile* file, int offset, int length)
+{
+    MemoryMapping* mapping;
+    int count, first;
+
+    if (offset < 0 || offset % PageSize != 0 || length <= 0 ||
+        length > UserAddrSpaceSize)
+        return -1;
+    count = divRoundUp(length, PageSize);
+    first = findMappingSpace(count);
+    if (first == -1)
+        return -1;
+
+    mapping = new MemoryMapping;
+    mapping->firstPage = first;
+    mapping->numPages = count;
+    mapping->file = file;
+    mapping->filePage = offset / PageSize;
+    file->numProcessesAccessing++;
+    mappings->Append(mapping);
+    DEBUG('a', "Mapped %d pages of %s at page %d\n", count, file->filename,
+          first);
+    return first * PageSize;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::munmap
+//     Unmap the file mapped at "virtAddr" by mmap, writing back the
+//     pages that were modified.  Returns 0, or -1 if nothing was
+//     mapped there.
+//----------------------------------------------------------------------
+
+int AddrSpace::munmap(int virtAddr)
+{
+    MemoryMapping* mapping;
+
+    if (virtAddr < 0 || virtAddr % PageSize != 0)
+        return -1;
+    mapping = findMapping(virtAddr / PageSize);
+    if (mapping == NULL || mapping->firstPage != virtAddr / PageSize)
+        return -1;
+
+    virtualMemoryManager->discardPages(this, mapping->firstPage,
+                                       mapping->numPages);
+    mappings->Remove(mapping);
+    mapping->file->closedBySingleProcess();
+    delete mapping;
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::findMapping
+//     Returns the mapped file page "pageTableIndex" is part of, or NULL.
+//----------------------------------------------------------------------
+
+MemoryMapping* AddrSpace::findMapping(int pageTableIndex)
+{
+    for (int i = 0; i < mappings->GetSize(); i++) {
+        MemoryMapping* mapping = (MemoryMapping*) mappings->GetElementAt(i);
+        if (pageTableIndex >= mapping->firstPage &&
+            pageTableIndex < mapping->firstPage + mapping->numPages)
+            return mapping;
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::heapLimit
+//     Returns the first page above the heap that is in use: the lowest
+//     mapped file, or else the stack.
+//----------------------------------------------------------------------
+
+int AddrSpace::heapLimit()
+{
+    int limit = stackStart;
+
+    for (int i = 0; i < mappings->GetSize(); i++) {
+        MemoryMapping* mapping = (MemoryMapping*) mappings->GetElementAt(i);
+        limit = min(limit, mapping->firstPage);
+    }
+    return limit;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::findMappingSpace
+//     Returns the highest page at which "count" pages can be mapped
+//     without overlapping another mapping, or the room the stack may
+//     grow into; or -1 if they would have to overlap the heap.
+//----------------------------------------------------------------------
+
+int AddrSpace::findMappingSpace(int count)
+{
+    int first = numPages - MaxStackSize / PageSize - count;
+    bool moved = TRUE;
+
+    while (first >= heapEnd && moved) {
+        moved = FALSE;
+        for (int i = 0; i < mappings->GetSize(); i++) {
+            MemoryMapping* mapping =
+                (MemoryMapping*) mappings->GetElementAt(i);
+            if (first < mapping->firstPage + mapping->numPages &&
+                mapping->firstPage < first + count) {
+                first = mapping->firstPage - count;
+                moved = TRUE;
+            }
+        }
+    }
+    return first >= heapEnd ? first : -1;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::initPageTable
+//     Start with an empty page directory: no second-level tables, and
+//     no swap extents for them.
+//----------------------------------------------------------------------
+
+void AddrSpace::initPageTable()
+{
+    numTables = divRoundUp(numPages, PageTableSpan);
+    pageDirectory = new TranslationEntry*[numTables];
+    swapExtents = new SwapExtent*[numTables];
+    for (int i = 0; i < numTables; i++) {
+        pageDirectory[i] = NULL;
+        swapExtents[i] = NULL;
+    }
+}
+
 //----------------------------------------------------------------------
 // AddrSpace::getPageTableEntry
 //     Helper function to assist virtual memory in cleanup of physical
-//     pages.
+//     pages.  The second-level table holding the entry is allocated the
+//     first time any of its pages is asked for; entries never move
+//     after that.
 //----------------------------------------------------------------------
 TranslationEntry* AddrSpace::getPageTableEntry(int pageTableIndex)
 {
-  //  printf("got this far tho = %d\n", pageTableIndex);
-    return &pageTable[pageTableIndex];
+    ASSERT(pageTableIndex >= 0 && pageTableIndex < (int) numPages);
+    TranslationEntry** table = &pageDirectory[pageTableIndex / PageTableSpan];
+
+    if (*table == NULL) {
+        *table = new TranslationEntry[PageTableSpan];
+        for (int i = 0; i < PageTableSpan; i++) {
+
+            // Set the usual bits for a new page.  A page only gets a
+            // swap sector once it's evicted dirty; until then it comes
+            // from the executable, or is zero-filled
+            (*table)[i].physicalPage = 0; // demand paging; not in swap
+            (*table)[i].valid = FALSE;
+            (*table)[i].use = FALSE;
+            (*table)[i].dirty = FALSE;
+            (*table)[i].readOnly = FALSE;
+        }
+    }
+    return *table + pageTableIndex % PageTableSpan;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::nextAllocatedPage
+//     Returns the first page from "pageTableIndex" on whose second-level
+//     table has been allocated, or getNumPages() if there is none, so
+//     that loops over the pages can skip the parts never used.
+//----------------------------------------------------------------------
+int AddrSpace::nextAllocatedPage(int pageTableIndex)
+{
+    while (pageTableIndex < (int) numPages &&
+           pageDirectory[pageTableIndex / PageTableSpan] == NULL)
+        pageTableIndex = (pageTableIndex / PageTableSpan + 1) * PageTableSpan;
+    return pageTableIndex;
 }
 
 //----------------------------------------------------------------------
@@ -355,11 +638,12 @@ TranslationEntry* AddrSpace::getPageTableEntry(int pageTableIndex)
 //----------------------------------------------------------------------
 int AddrSpace::getPageIndex(TranslationEntry* page)
 {
-    for (int i = 0; i < numPages; i++)
+    for (int i = 0; i < numTables; i++)
     {
-        if (page == pageTable + i)
+        if (pageDirectory[i] != NULL && page >= pageDirectory[i] &&
+            page < pageDirectory[i] + PageTableSpan)
         {
-            return i;
+            return i * PageTableSpan + (page - pageDirectory[i]);
         }
     }
     return -1;
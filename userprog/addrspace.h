@@ -18,21 +18,72 @@
 #include "pcb.h"
 #include "memorymanager.h"
 
+class Profile;
+class ExecFile;
+class SwapExtent;
+class SysOpenFile;
+class List;
+
 #ifdef VM
 
 #include "translate.h"
 
-#define UserStackSize		2048	// increase this as necessary!
+#define UserStackSize		2048	// the stack to start with; it grows
+					// as it is used, up to MaxStackSize
+#define MaxStackSize		(64 * 1024)
+#define UserAddrSpaceSize	(1 << 20)	// bytes of virtual address
+						// space; the stack is at the top
+
+/* The address space is laid out sparsely: code, data and bss, then the
+ * heap, growing upward (see sbrk), start at address 0; the stack grows
+ * downward from the top (see growStack); files mapped with Mmap go just
+ * below the furthest the stack can grow, working down; and the pages in
+ * between aren't part of it.  The page table has two levels (see
+ * PageTableSpan in translate.h), and a second-level table is only
+ * allocated once one of its pages is used, so the hole in the middle
+ * costs next to nothing.  New heap and stack pages are zero-filled when
+ * first touched, so they only take memory once they are used. */
+
+/* A range of pages of a file, mapped into an address space with Mmap.
+ * Its pages are brought in from the file, and written back to it, rather
+ * than to swap; every process mapping a page of the file shares the frame
+ * holding it (see VirtualMemoryManager::mapFilePage). */
+class MemoryMapping {
+  public:
+    int firstPage;                      // where it is in the address space
+    int numPages;
+    SysOpenFile* file;                  // the file, kept open while mapped
+    int filePage;                       // page of the file at firstPage
+};
 
 class AddrSpace {
   public:
     AddrSpace(const AddrSpace* other, PCB* pcb);  // Copy constructor
-    AddrSpace(OpenFile *executable, PCB* pcb);// Create an address space
+    AddrSpace(OpenFile *execFile, PCB* pcb, char *fileName);
+                                        // Create an address space running
+                                        // "execFile", opened as "fileName"
+    AddrSpace(int heapEnd, int stackStart, PCB* pcb);
+                                        // Create an empty address space,
+                                        // to be filled from a checkpoint
     ~AddrSpace();			// De-allocate an address space
 
     int Translate(int virtualAddress);  // Translates a virtual to physical addr
-    int ReadFile(int virtAddr, OpenFile* file, int size, int fileAddr);
+    bool fillPage(int pageTableIndex, char* into);  // contents of a page
+                                        // that isn't in swap; FALSE if
+                                        // it was just zero-filled
     int getNumPages() {return numPages;} // returns the number of pages held
+    bool isLegalPage(int pageTableIndex); // is it part of the address space?
+    int sbrk(int increment);            // move the end of the heap; returns
+                                        // the old one, or -1
+    bool growStack(int virtAddr, int stackPointer);
+                                        // extend the stack down to a fault
+                                        // at "virtAddr", if it's close enough
+    int mmap(SysOpenFile* file, int offset, int length);
+                                        // map part of "file"; returns its
+                                        // address, or -1
+    int munmap(int virtAddr);           // unmap what mmap put there
+    MemoryMapping* findMapping(int pageTableIndex); // NULL if not mapped
+    ExecFile* getExecutable() {return executable;} // NULL if none
 
     void InitRegisters();		// Initialize user-level CPU registers,
     void SaveState();			// Save/restore address space-specific
@@ -40,16 +91,48 @@ class AddrSpace {
     PCB* getPCB();                      // returns the associated PCB
     bool isValid();                     // means we allocated addrspace success
     TranslationEntry* getPageTableEntry(int pageTableIndex);
+                                        // allocates its table if need be
+    int nextAllocatedPage(int pageTableIndex);
+                                        // first page from there on that
+                                        // has a page table entry
     int getPageIndex(TranslationEntry* page);
-    TranslationEntry *pageTable;	// Assume linear page table translation
-					// for now!
-
-    int* locationOnDisk;
+    void ReportProfile();               // write out the execution profile
+    TranslationEntry **pageDirectory;	// two-level page table (see
+					// translate.h).  Where the pages that
+					// aren't valid are in swap is kept
+					// in their entries (see
+					// VirtualMemoryManager::getSwapLocation)
+
+    int nextSequentialFault;            // where a sequential sweep would
+                                        // fault next, and how many pages
+    int readAheadWindow;                // we read ahead at the last fault
+
+    SwapExtent** swapExtents;           // this space's slots in swap, one
+                                        // extent per second-level table,
+                                        // NULL until its pages need some
+    int asid;                           // tags its TLB entries (-tlb);
+                                        // -1 if we use page tables
+
+    int heapStart;                      // first page past code, data and
+                                        // bss, where the heap starts
+    int heapBreak;                      // address where the heap ends
+    int heapEnd;                        // first page past the heap
+    int stackStart;                     // lowest page of the stack
+    List* mappings;                     // the MemoryMappings of the files
+                                        // mapped with mmap
 
   private:
+    void initPageTable();               // an empty page directory
+    int heapLimit();                    // first page the heap can't grow to
+    int findMappingSpace(int count);    // where to map "count" pages
+
     unsigned int numPages;		// Number of pages in the virtual 
 					// address space
+    int numTables;                      // entries in the page directory
     PCB* pcb;                           // associated PCB
+    Profile* profile;                   // execution profile (-prof), or NULL
+    ExecFile* executable;               // where pages not in swap come
+                                        // from; NULL if they are zeroes
 };
 
 #else // don't use VM stuff
@@ -59,7 +142,8 @@ class AddrSpace {
 class AddrSpace {
   public:
     AddrSpace(const AddrSpace* other, PCB* pcb);  // Copy constructor
-    AddrSpace(OpenFile *executable, PCB* pcb);// Create an address space
+    AddrSpace(OpenFile *executable, PCB* pcb, char *fileName);
+                                        // Create an address space
     ~AddrSpace();			// De-allocate an address space
 
     int Translate(int virtualAddress);  // Translates a virtual to physical addr
@@ -71,6 +155,7 @@ class AddrSpace {
     void RestoreState();		// info on a context switch 
     PCB* getPCB();                      // returns the associated PCB
     bool isValid();                     // means we allocated addrspace success
+    void ReportProfile();               // write out the execution profile
     TranslationEntry *pageTable;	// Assume linear page table translation
 					// for now!
 
@@ -78,6 +163,7 @@ class AddrSpace {
     unsigned int numPages;		// Number of pages in the virtual 
 					// address space
     PCB* pcb;                           // associated PCB
+    Profile* profile;                   // execution profile (-prof), or NULL
 };
 
 #endif // VM or non-VM
@@ -23,6 +23,9 @@
 #include "syscall.h"
 #include "machine.h"
 #include "pcb.h"
+#ifdef VM
+#include "checkpoint.h"
+#endif
 
 #define MAX_FILENAME_LEN 128
 #define USER_READ 0 // passed as type for userReadWrite
@@ -44,7 +47,11 @@ int userReadWrite(int virtAddr, char* buffer, int size, int type);
 void writeImpl(void);
 int readImpl(void);
 void closeImpl(void);
+int sbrkImpl(void);
+int mmapImpl(void);
+int munmapImpl(void);
 void pageFaultHandler(void);
+void readOnlyHandler(void);
 
 //----------------------------------------------------------------------
 // ExceptionHandler
@@ -79,12 +86,27 @@ void ExceptionHandler(ExceptionType which)
     int type = machine->ReadRegister(2);
     PCB* pcb = (currentThread->space)->getPCB();
 
+#ifdef VM
+    // -ckpt: save the process at its first trap from the given tick on,
+    // before we handle it, so it is redone when the image is restored.
+    // Only a trap from user code will do: a page fault the kernel takes
+    // in the middle of a syscall would have the restored process redo
+    // the part of the syscall that had already run.
+    if (checkpointImage != NULL && stats->totalTicks >= checkpointTick &&
+            machine->userTrap && TakeCheckpoint(checkpointImage))
+        checkpointImage = NULL;
+    virtualMemoryManager->sampleResidency();
+    virtualMemoryManager->checkDedup();
+#endif
+
     if (which == SyscallException) {
+        stats->numSyscalls++;
 
         switch (type) { /* Find out what type of syscall we're dealing with */
 
             case SC_Halt:
                 DEBUG('v',"System Call: %d invoked Halt\n", pcb->getPID());
+                currentThread->space->ReportProfile();
                 interrupt->Halt();
                 break;
             case SC_Fork:
@@ -142,6 +164,21 @@ void ExceptionHandler(ExceptionType which)
                 DEBUG('v',"System Call: %d invoked Close\n", pcb->getPID());
                 closeImpl();
                 break;
+            case SC_Sbrk:
+                DEBUG('v',"System Call: %d invoked Sbrk\n", pcb->getPID());
+                result = sbrkImpl();
+                machine->WriteRegister(2, result);
+                break;
+            case SC_Mmap:
+                DEBUG('v',"System Call: %d invoked Mmap\n", pcb->getPID());
+                result = mmapImpl();
+                machine->WriteRegister(2, result);
+                break;
+            case SC_Munmap:
+                DEBUG('v',"System Call: %d invoked Munmap\n", pcb->getPID());
+                result = munmapImpl();
+                machine->WriteRegister(2, result);
+                break;
             default:
                 DEBUG('v',"System Call: %d invoked an unknown syscall!\n", 
                     pcb->getPID());
@@ -153,6 +190,8 @@ void ExceptionHandler(ExceptionType which)
 
     } else if (which == PageFaultException) {
         pageFaultHandler();
+    } else if (which == ReadOnlyException) {
+        readOnlyHandler();
     } else {
         fprintf(stderr,"Unexpected user mode exception %d %d\n", which, type);
         ASSERT(FALSE);
@@ -186,7 +225,7 @@ int forkImpl()
     childThread->space = new AddrSpace(currentThread->space, newPCB);
     int childNumPages = childThread->space->getNumPages();
 
-    if (childThread->space->pageTable == NULL) {
+    if (childThread->space->pageDirectory == NULL) {
         fprintf(stderr,"Process %d Fork: start at address 0x%x with %d pages"
                " memory failed\n", currPID, newProcessPC, childNumPages);
         return -1;
@@ -320,18 +359,17 @@ SpaceId execImpl(char* filename)
     pcb->process = newThread;
 
     // Give it an address space
-    AddrSpace* newSpace = new AddrSpace(fileToExecute, pcb);
+    AddrSpace* newSpace = new AddrSpace(fileToExecute, pcb, filename);
     if (!newSpace->isValid()) {
         DEBUG('v',"Exec Program: %d loading %s failed\n", currPID, filename);
-        delete fileToExecute;
         delete newSpace;
         return -1;
     }
     newThread->space = newSpace;
     processManager->addProcess(pcb, newPID);
 
-    // Close file and execute new process
-    delete fileToExecute;
+    // Execute new process; the address space pages it in from the
+    // file, and closes it when it's done
     DEBUG('v',"Exec Program: %d loading %s\n", currPID, filename);
     newThread->Fork(execHelper, 0);
     currentThread->Yield();
@@ -470,10 +508,12 @@ int userReadWrite(int virtAddr, char* buffer, int size, int type)
         while (size > 0)
         {
             // Need to use the machine->Translate so that page faults handled
-            // properly, instead of the addrspace->Translate
+            // properly, instead of the addrspace->Translate; we are
+            // writing, so the page gets marked dirty (and copied, if
+            // shared copy-on-write)
             do 
             {
-                exception = machine->Translate(virtAddr, &physAddr, size, FALSE);
+                exception = machine->Translate(virtAddr, &physAddr, size, TRUE);
                 if (exception != NoException) 
                 {
                     machine->RaiseException(exception, virtAddr);
@@ -482,6 +522,7 @@ int userReadWrite(int virtAddr, char* buffer, int size, int type)
             numBytesFromPSLeft = PageSize - physAddr % PageSize;
             numBytesToCopy = (numBytesFromPSLeft < size) ? numBytesFromPSLeft : size;
             bcopy(buffer + numBytesCopied, machine->mainMemory + physAddr, numBytesToCopy);
+            machine->InvalidateDecoded(physAddr, numBytesToCopy);
             numBytesCopied += numBytesToCopy;
             size -= numBytesToCopy;
             virtAddr += numBytesToCopy;
@@ -541,8 +582,8 @@ void writeImpl()
         } else {
             SysOpenFile* sysFile = 
                     fileManager->getFile(userFile->indexInSysOpenFileList);
-            int numBytesWritten = 
-                    sysFile->file->WriteAt(buffer, size, userFile->currOffsetInFile);
+            int numBytesWritten = virtualMemoryManager->writeFile(sysFile,
+                    buffer, size, userFile->currOffsetInFile);
             userFile->currOffsetInFile += numBytesWritten;
         }
     }
@@ -575,8 +616,8 @@ int readImpl()
         } 
         SysOpenFile* sysFile = 
                 fileManager->getFile(userFile->indexInSysOpenFileList);
-        numActualBytesRead = 
-                sysFile->file->ReadAt(buffer, size, userFile->currOffsetInFile);
+        numActualBytesRead = virtualMemoryManager->readFile(sysFile,
+                buffer, size, userFile->currOffsetInFile);
         userFile->currOffsetInFile += numActualBytesRead;
     }
     userReadWrite(readAddr, buffer, numActualBytesRead, USER_READ);
@@ -602,27 +643,126 @@ void closeImpl()
     }
 }
 
+//----------------------------------------------------------------------
+// Sbrk system call implementation: moves the end of the heap, and
+// returns where it was, or -1.
+//----------------------------------------------------------------------
+
+int sbrkImpl()
+{
+    int increment = machine->ReadRegister(4);
+    return currentThread->space->sbrk(increment);
+}
+
+//----------------------------------------------------------------------
+// Mmap system call implementation: maps part of an open file into the
+// address space, and returns where, or -1.
+//----------------------------------------------------------------------
+
+int mmapImpl()
+{
+    int fileID = machine->ReadRegister(4);
+    int offset = machine->ReadRegister(5);
+    int length = machine->ReadRegister(6);
+    UserOpenFile* userFile = currentThread->space->getPCB()->getFile(fileID);
+
+    if (userFile == NULL || fileID == ConsoleInput || fileID == ConsoleOutput)
+        return -1;
+    SysOpenFile* sysFile = 
+            fileManager->getFile(userFile->indexInSysOpenFileList);
+    return currentThread->space->mmap(sysFile, offset, length);
+}
+
+//----------------------------------------------------------------------
+// Munmap system call implementation: unmaps what Mmap mapped at an
+// address.
+//----------------------------------------------------------------------
+
+int munmapImpl()
+{
+    int virtAddr = machine->ReadRegister(4);
+    return currentThread->space->munmap(virtAddr);
+}
+
 //----------------------------------------------------------------------
 // Page fault handler that loads requested page into memory for
 // Project 3, which implements demand-paging.
+//
+// With a TLB (-tlb), this is also the TLB miss handler; most misses
+// are for pages that are in memory already, and only need the TLB
+// refilled from the page table.
 //----------------------------------------------------------------------
 
 void pageFaultHandler() 
 {
     int faultingVirtAddr = machine->ReadRegister(BadVAddrReg);
+    int virtPage = faultingVirtAddr / PageSize;
+    AddrSpace* space = currentThread->space;
+    int start = stats->totalTicks;
+
+    // In the hole between the heap and the stack (or, with a TLB, past
+    // the end of the page table, where the hardware would otherwise
+    // have raised an address error), unless the stack is growing into it
+    if (!space->isLegalPage(virtPage) &&
+        !space->growStack(faultingVirtAddr, machine->ReadRegister(StackReg))) {
+        fprintf(stderr, "Process %d: address 0x%x is not in its address "
+                "space\n", space->getPCB()->getPID(), faultingVirtAddr);
+        ASSERT(FALSE);
+    }
+
+    if (tlbManager != NULL) {
+        if (space->getPageTableEntry(virtPage)->valid) {
+            tlbManager->Refill(space, virtPage);
+            return;
+        }
+    }
 
  //   fprintf(stderr, "swappinggggg...************ %d\n", faultingVirtAddr);      
 
+    stats->numPageFaults++;
     virtualMemoryManager->swapPageIn(faultingVirtAddr);
+    space->getPCB()->paging.FaultHandled(stats->totalTicks - start);
+    if (tlbManager != NULL)
+        tlbManager->Refill(space, virtPage);
 
-    int pid = currentThread->space->getPCB()->getPID();
-    int virtPage = faultingVirtAddr / PageSize;
-    int physPage = currentThread->space->getPageTableEntry(virtPage)->physicalPage;
+    int pid = space->getPCB()->getPID();
+    int physPage = space->getPageTableEntry(virtPage)->physicalPage;
 
 //    fprintf(stderr,"L %d: %d -> %d\n", pid, virtPage, physPage);
     DEBUG('v',"L %d: %d -> %d\n", pid, virtPage, physPage);
 }
 
+//----------------------------------------------------------------------
+// Handler for a write to a read-only page, which is a page shared
+// copy-on-write after a Fork: give the process its own copy.
+//
+// With a TLB, it may also be the first write to a page, which is only
+// write-protected in the TLB so that we can mark it dirty now; in any
+// case, the TLB gets a writable translation.
+//----------------------------------------------------------------------
+
+void readOnlyHandler()
+{
+    int faultingVirtAddr = machine->ReadRegister(BadVAddrReg);
+    int virtPage = faultingVirtAddr / PageSize;
+    AddrSpace* space = currentThread->space;
+    TranslationEntry* page = space->getPageTableEntry(virtPage);
+    int start = stats->totalTicks;
+
+    if (page->readOnly) {
+        virtualMemoryManager->copyOnWrite(faultingVirtAddr);
+        space->getPCB()->paging.FaultHandled(stats->totalTicks - start);
+
+        DEBUG('v',"C %d: %d\n", space->getPCB()->getPID(), virtPage);
+    } else
+        ASSERT(tlbManager != NULL);
+
+    if (tlbManager != NULL) {
+        page->dirty = TRUE;     // as the hardware would on the retry
+        tlbManager->Refill(space, virtPage);
+    }
+}
+
 //----------------------------------------------------------------------
 // IncrementPC
 //      Helper function used to increment the values of PCreg, NextPCreg,
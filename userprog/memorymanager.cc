@@ -35,6 +35,11 @@ void MemoryManager::clearPage(int pageIndex) {
     physPageAllocation->Clear(pageIndex);
 }
 
+// Allocates a specific page (when restoring a checkpoint)
+void MemoryManager::markPage(int pageIndex) {
+    physPageAllocation->Mark(pageIndex);
+}
+
 // Returns the number of available pages
 int MemoryManager::getNumFreePages() {
     return physPageAllocation->NumClear();
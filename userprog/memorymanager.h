@@ -17,6 +17,7 @@ class MemoryManager {
         ~MemoryManager();
         int getPage();                // allocates the first clear page
         void clearPage(int);          // frees the page at specified index
+        void markPage(int);           // allocates the page at specified index
         int getNumFreePages();        // returns the number of free pages
 
     private:
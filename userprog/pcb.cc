@@ -13,7 +13,8 @@
 //     Constructor
 //-----------------------------------------------------------------------------
 
-PCB::PCB(int pid, int parentPID) : openFilesBitMap(MAX_NUM_FILES_OPEN) {
+PCB::PCB(int pid, int parentPID) : paging(pid),
+                                   openFilesBitMap(MAX_NUM_FILES_OPEN) {
 
     this->pid = pid;
     this->parentPID = parentPID;
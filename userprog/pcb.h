@@ -9,6 +9,7 @@
 
 #include "bitmap.h"
 #include "useropenfile.h"
+#include "stats.h"
 
 // Process status
 #define P_GOOD    0;
@@ -28,6 +29,7 @@ class PCB {
         int getPID();
         int status;
         Thread* process;
+        PagingStatistics paging; // what paging this process caused
         int addFile(UserOpenFile file);
         UserOpenFile* getFile(int fileID);
         void removeFile(int fileID);
@@ -154,3 +154,13 @@ int ProcessManager::isAllFinished() { //Is all finished except 0?
     }
     return 1;
 }
+
+//-----------------------------------------------------------------------------
+// ProcessManager::getNumProcesses
+//     Returns how many PIDs are in use, by running processes or by ones
+//     that have exited but may still be joined.
+//-----------------------------------------------------------------------------
+
+int ProcessManager::getNumProcesses() {
+    return MAX_PROCESSES - processesBitMap.NumClear();
+}
@@ -27,6 +27,7 @@ class ProcessManager {
         void broadcast(int pid);
         void join(int pid);
         int isAllFinished();
+        int getNumProcesses();   // PIDs currently in use
 
 
     private:
@@ -0,0 +1,282 @@
+// profile.cc
+//	Routines to collect and report an execution profile of a user
+//	program.  See profile.h; the counting itself is done by
+//	Machine::OneInstruction, through Profile::Count.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "profile.h"
+#include "noff.h"
+#include "mipssim.h"
+#include "machine.h"
+#include "addrspace.h"
+
+#define NumHottest	20		// instructions listed as "hottest"
+
+static bool reported[MAX_PROCESSES];	// have we written this pid's file
+					// yet, during this run?
+
+//----------------------------------------------------------------------
+// Profile::Profile
+// 	Set up to profile a program that was just loaded from a NOFF
+//	file with header "noffH", into an address space of "size" bytes
+//	(all of it, heap, stack and hole included).
+//----------------------------------------------------------------------
+
+Profile::Profile(struct noffHeader *noffH, int size, int processID)
+{
+    Init(size, processID);
+    codeStart = noffH->code.virtualAddr;
+    codeSize = noffH->code.size;
+    dataStart = noffH->initData.virtualAddr;
+    dataSize = noffH->initData.size;
+    bssStart = noffH->uninitData.virtualAddr;
+    bssSize = noffH->uninitData.size;
+}
+
+//----------------------------------------------------------------------
+// Profile::Profile
+// 	Set up to profile a process forked from the one "other" is
+//	profiling.  The child runs the same program, so we keep its
+//	segment layout, but start counting from zero.
+//----------------------------------------------------------------------
+
+Profile::Profile(const Profile *other, int processID)
+{
+    Init(other->spaceSize, processID);
+    codeStart = other->codeStart;
+    codeSize = other->codeSize;
+    dataStart = other->dataStart;
+    dataSize = other->dataSize;
+    bssStart = other->bssStart;
+    bssSize = other->bssSize;
+}
+
+//----------------------------------------------------------------------
+// Profile::Init
+// 	Set up the counters for an address space of "size" bytes.  Those
+//	for the instructions on each page are only allocated once one of
+//	them executes (see NewPage).
+//----------------------------------------------------------------------
+
+void
+Profile::Init(int size, int processID)
+{
+    ASSERT(MaxOpcode < ProfiledOpcodes);
+    pid = processID;
+    spaceSize = size;
+    pages = new PageCounts *[divRoundUp(size, PageSize)];
+    bzero(pages, divRoundUp(size, PageSize) * sizeof(PageCounts *));
+    otherCount = 0;
+    bzero(opCounts, sizeof(opCounts));
+    bzero(takenCounts, sizeof(takenCounts));
+}
+
+//----------------------------------------------------------------------
+// Profile::~Profile
+// 	De-allocate the counters.
+//----------------------------------------------------------------------
+
+Profile::~Profile()
+{
+    for (int i = 0; i < divRoundUp(spaceSize, PageSize); i++)
+	delete pages[i];
+    delete [] pages;
+}
+
+//----------------------------------------------------------------------
+// Profile::NewPage
+// 	Allocate and clear the counters for the instructions on virtual
+//	page "page", the first time one of them executes.
+//----------------------------------------------------------------------
+
+PageCounts *
+Profile::NewPage(int page)
+{
+    pages[page] = new PageCounts;
+    bzero(pages[page], sizeof(PageCounts));
+    return pages[page];
+}
+
+//----------------------------------------------------------------------
+// Profile::Label
+// 	Describe virtual address "addr" of "space" as an offset into the
+//	region that contains it, e.g. "code+0x1a4": a NOFF segment, a
+//	file mapped with Mmap ("mmap"), the stack, or else the heap.  An
+//	address that was unmapped, or cut off the heap, since it ran is
+//	just "none".
+//----------------------------------------------------------------------
+
+char *
+Profile::Label(AddrSpace *space, int addr, char *buf)
+{
+    MemoryMapping *mapping = space->findMapping(addr / PageSize);
+
+    if (addr >= codeStart && addr < codeStart + codeSize)
+	sprintf(buf, "code+0x%x", addr - codeStart);
+    else if (addr >= dataStart && addr < dataStart + dataSize)
+	sprintf(buf, "data+0x%x", addr - dataStart);
+    else if (addr >= bssStart && addr < bssStart + bssSize)
+	sprintf(buf, "bss+0x%x", addr - bssStart);
+    else if (mapping != NULL)
+	sprintf(buf, "mmap+0x%x", addr - mapping->firstPage * PageSize);
+    else if (addr >= space->stackStart * PageSize)
+	sprintf(buf, "stack+0x%x", addr - space->stackStart * PageSize);
+    else if (addr >= space->heapStart * PageSize &&
+	     addr < space->heapEnd * PageSize)
+	sprintf(buf, "heap+0x%x", addr - space->heapStart * PageSize);
+    else
+	sprintf(buf, "none");
+    return buf;
+}
+
+//----------------------------------------------------------------------
+// Mnemonic
+// 	The name of an opcode, e.g. "ADDIU", taken from opStrings.
+//----------------------------------------------------------------------
+
+static char *
+Mnemonic(int opCode, char *buf)
+{
+    int i;
+
+    for (i = 0; opStrings[opCode].string[i] != ' ' &&
+	     opStrings[opCode].string[i] != '\0' && i < 15; i++)
+	buf[i] = opStrings[opCode].string[i];
+    buf[i] = '\0';
+    return buf;
+}
+
+//----------------------------------------------------------------------
+// Profile::CountOf
+// 	How many times the word at index "word" of the address space was
+//	executed.
+//----------------------------------------------------------------------
+
+unsigned int
+Profile::CountOf(int word)
+{
+    PageCounts *counts = pages[word / WordsPerPage];
+
+    return (counts == NULL) ? 0 : counts->pcCounts[word % WordsPerPage];
+}
+
+//----------------------------------------------------------------------
+// Profile::PrintWord
+// 	Write out the line for the word at index "word" of "space": its
+//	address and region, and what was executed there.
+//----------------------------------------------------------------------
+
+void
+Profile::PrintWord(FILE *out, AddrSpace *space, int word)
+{
+    PageCounts *counts = pages[word / WordsPerPage];
+    int w = word % WordsPerPage;
+    char label[32], name[16];
+
+    fprintf(out, "0x%08x %-16s %-8s %14u %8u\n", word * 4,
+	    Label(space, word * 4, label),
+	    Mnemonic(counts->pcOpCodes[w], name), counts->pcCounts[w],
+	    counts->pcTaken[w]);
+}
+
+//----------------------------------------------------------------------
+// Profile::Report
+// 	Write the profile to "nachos.prof.<pid>": totals, the opcode
+//	histogram, the hottest instructions, and then every instruction
+//	that was executed at all, in address order.  "space" is the
+//	address space being profiled, as it is now: the heap, stack and
+//	mapped files may have moved since the program started.
+//
+//	The first report for a pid during a run starts a new file; any
+//	later process that gets the same pid appends to it.
+//----------------------------------------------------------------------
+
+void
+Profile::Report(AddrSpace *space)
+{
+    char fileName[32], name[16];
+    int hottest[NumHottest];
+    int numHottest = 0;
+    unsigned int total = otherCount;
+    unsigned int loads, stores, branches, taken;
+    int words = spaceSize / 4;
+    int i, j;
+
+    sprintf(fileName, "nachos.prof.%d", pid);
+    FILE *out = fopen(fileName, reported[pid] ? "a" : "w");
+    if (out == NULL) {
+	fprintf(stderr, "Unable to write profile %s\n", fileName);
+	return;
+    }
+    reported[pid] = TRUE;
+
+    for (i = 0; i <= MaxOpcode; i++)
+	total += opCounts[i];
+    loads = opCounts[OP_LB] + opCounts[OP_LBU] + opCounts[OP_LH] +
+	opCounts[OP_LHU] + opCounts[OP_LW] + opCounts[OP_LWL] +
+	opCounts[OP_LWR];
+    stores = opCounts[OP_SB] + opCounts[OP_SH] + opCounts[OP_SW] +
+	opCounts[OP_SWL] + opCounts[OP_SWR];
+    branches = opCounts[OP_BEQ] + opCounts[OP_BNE] + opCounts[OP_BLEZ] +
+	opCounts[OP_BGTZ] + opCounts[OP_BLTZ] + opCounts[OP_BGEZ] +
+	opCounts[OP_BLTZAL] + opCounts[OP_BGEZAL];
+    taken = takenCounts[OP_BEQ] + takenCounts[OP_BNE] +
+	takenCounts[OP_BLEZ] + takenCounts[OP_BGTZ] +
+	takenCounts[OP_BLTZ] + takenCounts[OP_BGEZ] +
+	takenCounts[OP_BLTZAL] + takenCounts[OP_BGEZAL];
+
+    fprintf(out, "Profile of process %d at tick %d\n", pid, stats->totalTicks);
+    fprintf(out, "Segments: code 0x%x-0x%x, data 0x%x-0x%x, "
+	    "bss 0x%x-0x%x, heap 0x%x-0x%x, stack 0x%x-0x%x\n",
+	    codeStart, codeStart + codeSize, dataStart, dataStart + dataSize,
+	    bssStart, bssStart + bssSize, space->heapStart * PageSize,
+	    space->heapBreak, space->stackStart * PageSize, spaceSize);
+    for (i = 0; i < space->mappings->GetSize(); i++) {
+	MemoryMapping *mapping =
+	    (MemoryMapping *) space->mappings->GetElementAt(i);
+	fprintf(out, "Mapped: 0x%x-0x%x\n", mapping->firstPage * PageSize,
+		(mapping->firstPage + mapping->numPages) * PageSize);
+    }
+    fprintf(out, "Instructions %u, loads %u, stores %u, "
+	    "branches %u (%u taken)\n", total, loads, stores, branches, taken);
+    if (otherCount > 0)
+	fprintf(out, "Executed outside the address space: %u\n", otherCount);
+
+    fprintf(out, "\nOpcode            count    %%    taken\n");
+    for (i = 1; i <= MaxOpcode; i++)
+	if (opCounts[i] > 0)
+	    fprintf(out, "%-8s %14u %5.1f %8u\n", Mnemonic(i, name),
+		    opCounts[i], 100.0 * opCounts[i] / total, takenCounts[i]);
+
+    // Keep the NumHottest busiest words, busiest first
+    for (i = 0; i < words; i++) {
+	if (CountOf(i) == 0)
+	    continue;
+	for (j = numHottest; j > 0 && CountOf(hottest[j - 1]) < CountOf(i);
+	     j--)
+	    if (j < NumHottest)
+		hottest[j] = hottest[j - 1];
+	if (j < NumHottest) {
+	    hottest[j] = i;
+	    if (numHottest < NumHottest)
+		numHottest++;
+	}
+    }
+    fprintf(out, "\nHottest instructions\n");
+    fprintf(out, "Address    Where            Opcode            count    taken\n");
+    for (i = 0; i < numHottest; i++)
+	PrintWord(out, space, hottest[i]);
+
+    fprintf(out, "\nAll instructions executed\n");
+    fprintf(out, "Address    Where            Opcode            count    taken\n");
+    for (i = 0; i < words; i++)
+	if (CountOf(i) > 0)
+	    PrintWord(out, space, i);
+    fprintf(out, "\n");
+    fclose(out);
+}
@@ -0,0 +1,99 @@
+// profile.h
+//	Data structures for profiling the execution of a user program.
+//
+//	When nachos is run with -prof, every address space gets a
+//	Profile, which the simulator fills in as it executes the
+//	program's instructions: how many times each instruction (by
+//	virtual address) and each opcode was executed, and how often
+//	branches were taken.  When the process exits, or halts the
+//	machine, the counts are written to the file "nachos.prof.<pid>",
+//	with each address labelled by the region it falls in: a NOFF
+//	segment, the heap, the stack or a file mapped with Mmap.
+//
+//	The address space is sparse (see addrspace.h), so the counts for
+//	each page are only allocated once an instruction on it executes.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "copyright.h"
+#include "machine.h"
+
+// Room for every opcode number (0..MaxOpcode in mipssim.h, which only
+// the simulator and profile.cc need to include)
+#define ProfiledOpcodes	64
+
+#define WordsPerPage	(PageSize / 4)
+
+struct noffHeader;
+class AddrSpace;
+
+// The counts for the instructions on one page of the address space
+struct PageCounts {
+    unsigned int pcCounts[WordsPerPage];	// executions of each word
+    unsigned int pcTaken[WordsPerPage];	// ... that branched away
+    unsigned char pcOpCodes[WordsPerPage];	// opcode last executed there
+};
+
+class Profile {
+  public:
+    Profile(struct noffHeader *noffH, int spaceSize, int pid);
+    					// Profile a new program, whose
+					// address space is "spaceSize" bytes
+    Profile(const Profile *other, int pid);
+    					// Profile a forked copy of "other"
+    ~Profile();
+
+    void Count(int pc, int opCode, bool taken) {
+    					// Record one executed instruction;
+					// "taken" if it changed the flow
+					// of control
+	opCounts[opCode]++;
+	if ((unsigned) pc < (unsigned) spaceSize) {
+	    PageCounts *counts = pages[pc / PageSize];
+	    int word = (pc % PageSize) / 4;
+
+	    if (counts == NULL)
+		counts = NewPage(pc / PageSize);
+	    counts->pcCounts[word]++;
+	    counts->pcOpCodes[word] = opCode;
+	    if (taken) {
+		counts->pcTaken[word]++;
+		takenCounts[opCode]++;
+	    }
+	} else {
+	    otherCount++;
+	}
+    }
+
+    void Report(AddrSpace *space);	// Write out what we have so far;
+					// "space" tells where its heap,
+					// stack and mapped files are
+
+  private:
+    void Init(int size, int processID);	// Allocate and clear the counts
+    PageCounts *NewPage(int page);	// Start counting on "page"
+    unsigned int CountOf(int word);	// Executions of word number "word"
+    void PrintWord(FILE *out, AddrSpace *space, int word);
+    					// One line of the report
+    char *Label(AddrSpace *space, int addr, char *buf);
+    					// "region+offset" for "addr"
+
+    int pid;				// process being profiled
+    int spaceSize;			// bytes of virtual address space
+    int codeStart, codeSize;		// NOFF segment layout
+    int dataStart, dataSize;
+    int bssStart, bssSize;
+
+    PageCounts **pages;			// the counts for each page, or
+					// NULL if nothing ran there
+    unsigned int otherCount;		// executions outside the space (!)
+    unsigned int opCounts[ProfiledOpcodes];
+    unsigned int takenCounts[ProfiledOpcodes];
+};
+
+#endif // PROFILE_H
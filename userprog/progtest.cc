@@ -33,10 +33,13 @@ StartProcess(char *filename)
     PCB* newPCB = new PCB(newPID, -1);
     newPCB->status = P_RUNNING;
     processManager->addProcess(newPCB, newPID);
-    AddrSpace* space = new AddrSpace(executable, newPCB);    
+    AddrSpace* space = new AddrSpace(executable, newPCB, filename);    
     currentThread->space = space;
 
+#ifndef VM
     delete executable;			// close file
+#endif					// (with VM, the address space
+					// pages in from it, and closes it)
 
     if ((space->getPCB())->getPID() == -1) {
         fprintf(stderr,"Unable to acquire valid PCB for process. Terminating.\n");
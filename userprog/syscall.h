@@ -29,6 +29,9 @@
 #define SC_Close	8
 #define SC_Fork		9
 #define SC_Yield	10
+#define SC_Sbrk		11
+#define SC_Mmap		12
+#define SC_Munmap	13
 
 #ifndef IN_ASM
 
@@ -124,6 +127,33 @@ void Fork(void (*func)());
  */
 void Yield();		
 
+
+/* Memory allocation: Sbrk.  The heap starts just past the program's
+ * data, and grows upward; the stack grows downward on its own, as it is
+ * used.
+ */
+
+/* Move the end of the heap by "increment" bytes (less than zero gives
+ * memory back), and return the old end, where the new memory starts.
+ * Return (void *) -1 if the heap can't be moved that far.  New memory
+ * is zero-filled.
+ */
+void *Sbrk(int increment);
+
+/* Map "length" bytes of the open file "id", from "offset" (a multiple of
+ * the page size) on, into the address space, and return where they are,
+ * or (void *) -1 if they don't fit.  Loads and stores there read and
+ * write the file, and every process mapping it sees the same bytes, as do
+ * Read and Write.  Bytes past the end of the file read as zeroes, and
+ * aren't written back.  The file stays mapped until Munmap, or Exit.
+ */
+void *Mmap(OpenFileId id, int offset, int length);
+
+/* Unmap the file Mmap mapped at "addr", writing the changes made to it
+ * back.  Return 0, or -1 if nothing was mapped there.
+ */
+int Munmap(void *addr);
+
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */
@@ -0,0 +1,197 @@
+// checkpoint.cc
+//	Routines to write a checkpoint image of the running user process,
+//	and to start nachos from one.  See checkpoint.h for what is saved.
+//
+//	A checkpoint is requested with "-ckpt <image> <tick>": the first
+//	time the user program traps into the kernel at or after that tick,
+//	ExceptionHandler calls TakeCheckpoint.  "-restore <image>" then
+//	runs the process from the image, in place of "-x".
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "checkpoint.h"
+#include "addrspace.h"
+#include "virtualmemorymanager.h"
+
+//----------------------------------------------------------------------
+// Align
+// 	Round "offset" up to the start of the next section.
+//----------------------------------------------------------------------
+
+static int
+Align(int offset)
+{
+    return divRoundUp(offset, CheckpointAlign) * CheckpointAlign;
+}
+
+//----------------------------------------------------------------------
+// WriteSection
+// 	Write "size" bytes from "buffer" at "offset" into the image "fd".
+//----------------------------------------------------------------------
+
+static void
+WriteSection(int fd, int offset, char *buffer, int size)
+{
+    Lseek(fd, offset, 0);
+    WriteFile(fd, buffer, size);
+}
+
+//----------------------------------------------------------------------
+// TakeCheckpoint
+// 	Save the machine, and the process currently running on it, to
+//	the file "imageName".
+//
+//	Returns FALSE, without writing anything, if there is more than
+//	one process (or none), or it has files mapped (which we can't
+//	reopen), so the caller can try again later.
+//----------------------------------------------------------------------
+
+bool
+TakeCheckpoint(char *imageName)
+{
+    AddrSpace *space = currentThread->space;
+    CheckpointHeader header;
+    char page[PageSize];
+    int numPages, numSaved, fd, i, n;
+
+    if (space == NULL || processManager->getNumProcesses() != 1 ||
+	    !space->mappings->IsEmpty())
+	return FALSE;
+    numPages = space->getNumPages();
+    numSaved = space->heapEnd + numPages - space->stackStart;
+
+    bzero((char *) &header, sizeof(header));
+    header.magic = CheckpointMagic;
+    header.version = CheckpointVersion;
+    header.memorySize = MemorySize;
+    header.pageSize = PageSize;
+    header.numPages = numPages;
+    header.heapEnd = space->heapEnd;
+    header.stackStart = space->stackStart;
+    header.heapStart = space->heapStart;
+    header.heapBreak = space->heapBreak;
+    header.nextVictim = virtualMemoryManager->getNextVictim();
+    for (i = 0; i < NumTotalRegs; i++)
+	header.registers[i] = machine->ReadRegister(i);
+    header.stats = *stats;
+    header.memoryOffset = Align(sizeof(header));
+    header.pageTableOffset = header.memoryOffset + Align(MemorySize);
+    header.swapOffset = header.pageTableOffset +
+	Align(numSaved * sizeof(TranslationEntry));
+    header.size = header.swapOffset + numSaved * PageSize;
+
+    fd = OpenForWrite(imageName);
+    WriteSection(fd, 0, (char *) &header, sizeof(header));
+    WriteSection(fd, header.memoryOffset, machine->mainMemory, MemorySize);
+    for (i = 0, n = 0; i < numPages; i++) {
+	int location;
+
+	if (!space->isLegalPage(i))
+	    continue;
+	location = virtualMemoryManager->getSwapLocation(space, i);
+	if (location >= 0)
+	    virtualMemoryManager->readFromSwap(page, PageSize, location);
+	else
+	    space->fillPage(i, page);
+	WriteSection(fd, header.pageTableOffset + n * sizeof(TranslationEntry),
+		     (char *) space->getPageTableEntry(i),
+		     sizeof(TranslationEntry));
+	WriteSection(fd, header.swapOffset + n * PageSize, page, PageSize);
+	n++;
+    }
+    Close(fd);
+
+    DEBUG('v', "Checkpoint of %d pages written to %s at tick %d\n",
+	  numSaved, imageName, stats->totalTicks);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// RestoreProcess
+// 	Put the machine back the way it was when "imageName" was
+//	written, and run the saved process from there.  Like
+//	StartProcess, this never returns unless the image can't be used.
+//----------------------------------------------------------------------
+
+void
+RestoreProcess(char *imageName)
+{
+    CheckpointHeader header;
+    AddrSpace *space;
+    PCB *pcb;
+    char *image;
+    int size, pid, numPages, i, n;
+
+    image = MapFile(imageName, &size);
+    if (image == NULL) {
+	fprintf(stderr, "Unable to open checkpoint %s\n", imageName);
+	return;
+    }
+    if (size >= (int) sizeof(header))
+	bcopy(image, (char *) &header, sizeof(header));
+    if (size < (int) sizeof(header) || header.magic != CheckpointMagic ||
+	    header.version != CheckpointVersion || header.size != size ||
+	    header.memorySize != MemorySize || header.pageSize != PageSize ||
+	    header.numPages != UserAddrSpaceSize / PageSize) {
+	fprintf(stderr, "%s is not a checkpoint of this machine\n", imageName);
+	UnmapFile(image, size);
+	return;
+    }
+    numPages = header.numPages;
+
+    pid = processManager->getPID();
+    pcb = new PCB(pid, -1);
+    pcb->status = P_RUNNING;
+    processManager->addProcess(pcb, pid);
+    space = new AddrSpace(header.heapEnd, header.stackStart, pcb);
+    space->heapStart = header.heapStart;
+    space->heapBreak = header.heapBreak;
+    currentThread->space = space;
+
+    for (i = 0, n = 0; i < numPages; i++) {
+	TranslationEntry *entry;
+	bool valid;
+	int frame, location;
+
+	if (!space->isLegalPage(i))
+	    continue;
+	entry = space->getPageTableEntry(i);
+	bcopy(image + header.pageTableOffset + n * sizeof(TranslationEntry),
+	      (char *) entry, sizeof(TranslationEntry));
+	valid = entry->valid;
+	frame = entry->physicalPage;
+
+	// The executable isn't kept, so pages that would have been read
+	// from it go into swap too.  Entries that weren't valid held where
+	// the page was in the old swap file; it's in the new one now.
+	entry->valid = FALSE;
+	location = virtualMemoryManager->allocSwapSlot(space, i);
+	virtualMemoryManager->writeToSwap(image + header.swapOffset +
+					  n * PageSize, PageSize, location);
+	virtualMemoryManager->setSwapLocation(space, i, location);
+	if (valid) {
+	    virtualMemoryManager->claimFrame(frame, space, i);
+	    entry->valid = TRUE;
+	}
+	n++;
+    }
+    virtualMemoryManager->setNextVictim(header.nextVictim);
+
+    bcopy(image + header.memoryOffset, machine->mainMemory, MemorySize);
+    machine->InvalidateDecoded(0, MemorySize);
+    for (i = 0; i < NumTotalRegs; i++)
+	machine->WriteRegister(i, header.registers[i]);
+    *stats = header.stats;
+    UnmapFile(image, size);
+
+    DEBUG('v', "Restored %d pages from %s at tick %d\n", n,
+	  imageName, stats->totalTicks);
+
+    space->RestoreState();		// load page table register
+    machine->Run();			// carry on from the trap
+    ASSERT(FALSE);			// machine->Run never returns
+}
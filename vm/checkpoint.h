@@ -0,0 +1,69 @@
+// checkpoint.h
+//	Save a running user program, together with the simulated machine
+//	around it, to an image file, so that a later run of nachos can
+//	pick it up from there instead of starting the program over.
+//
+//	An image holds the user registers, all of main memory, the
+//	process's page table entries (so which frame holds which page),
+//	the contents of each of its pages as found in swap (or in the
+//	executable), the hand of the page replacement clock, and the
+//	statistics (so simulated time carries on where it left off).
+//	Only the pages that are part of the address space are saved --
+//	those of the program and heap, then those of the stack -- not the
+//	unused middle.  Where the pages were in swap isn't kept: a
+//	restored process gets a fresh swap extent, and every page is
+//	written to its slot there.
+//
+//	Each section starts at a page-aligned offset recorded in the
+//	header, so that restoring is a matter of mapping the file and
+//	copying the sections into place.
+//
+//	Kernel threads and their host stacks can't be saved, so a
+//	checkpoint is only taken while the process is alone in the
+//	system, at the moment it traps into the kernel (for a syscall or
+//	a page fault) -- from user code, not when the kernel faults on
+//	user memory in the middle of a syscall.  The PC still points at
+//	the trapping instruction, so the restored program simply executes
+//	it again.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "copyright.h"
+#include "machine.h"
+#include "stats.h"
+
+#define CheckpointMagic		0x4b50434e	// "NCPK", as stored on disk
+#define CheckpointVersion	7
+#define CheckpointAlign		4096		// sections start on host pages
+
+// The start of every image file.
+class CheckpointHeader {
+  public:
+    int magic;			// CheckpointMagic
+    int version;		// CheckpointVersion
+    int memorySize;		// the configuration the image was taken
+    int pageSize;		// with; it must match ours to be restored
+    int numPages;		// pages in the process's address space
+    int heapEnd;		// how much of them are program and heap,
+    int stackStart;		// and stack (the pages saved)
+    int heapStart;		// where the heap starts (a page), and
+    int heapBreak;		// ends (an address)
+    int nextVictim;		// clock hand of the page replacement
+    int registers[NumTotalRegs];  // user-level CPU state
+    Statistics stats;		// simulated time, fault counts, ...
+    int memoryOffset;		// where each section starts in the file
+    int pageTableOffset;
+    int swapOffset;
+    int size;			// length of the whole image
+};
+
+extern bool TakeCheckpoint(char *imageName);	// Save the current
+					// process, if it's the only one
+extern void RestoreProcess(char *imageName);	// Run a saved process
+
+#endif // CHECKPOINT_H
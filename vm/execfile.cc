@@ -0,0 +1,144 @@
+// execfile.cc
+//	Routines to page a program in from its executable.  See
+//	execfile.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "execfile.h"
+#include "noff.h"
+
+static List *execFiles = NULL;		// the ExecFiles in use
+
+//----------------------------------------------------------------------
+// ExecFile::ExecFile
+// 	Remember where the code and initialized data of the program in
+//	"executable" are, from its (already byte-swapped) header "noffH",
+//	and that it is the file called "fileName", in case another
+//	process runs it.
+//----------------------------------------------------------------------
+
+ExecFile::ExecFile(char *fileName, OpenFile *executable,
+		   struct noffHeader *noffH)
+{
+    name = new char[strlen(fileName) + 1];
+    strcpy(name, fileName);
+    file = executable;
+    codeAddr = noffH->code.virtualAddr;
+    codeInFile = noffH->code.inFileAddr;
+    codeSize = noffH->code.size;
+    dataAddr = noffH->initData.virtualAddr;
+    dataInFile = noffH->initData.inFileAddr;
+    dataSize = noffH->initData.size;
+    refs = 1;
+
+    if (execFiles == NULL)
+	execFiles = new List;
+    execFiles->Append(this);
+}
+
+//----------------------------------------------------------------------
+// ExecFile::~ExecFile
+// 	Close the executable.
+//----------------------------------------------------------------------
+
+ExecFile::~ExecFile()
+{
+    execFiles->Remove(this);
+    delete [] name;
+    delete file;
+}
+
+//----------------------------------------------------------------------
+// ExecFile::Find
+// 	Return the ExecFile of a program some process is running from
+//	the file "fileName", or NULL if there's none.
+//----------------------------------------------------------------------
+
+ExecFile *
+ExecFile::Find(char *fileName)
+{
+    if (execFiles == NULL)
+	return NULL;
+    for (int i = 0; i < execFiles->GetSize(); i++) {
+	ExecFile *exec = (ExecFile *) execFiles->GetElementAt(i);
+	if (!strcmp(exec->name, fileName))
+	    return exec;
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// ExecFile::Release
+// 	Called when a process using the file goes away.
+//----------------------------------------------------------------------
+
+void
+ExecFile::Release()
+{
+    ASSERT(refs > 0);
+    if (--refs == 0)
+	delete this;
+}
+
+//----------------------------------------------------------------------
+// ReadSegment
+// 	Copy the part of a segment ("size" bytes at "addr" in the
+//	address space, "inFile" in "file") that falls into the page
+//	starting at "pageAddr", into "into".  Returns FALSE if none of
+//	it does.
+//----------------------------------------------------------------------
+
+static bool
+ReadSegment(OpenFile *file, int addr, int inFile, int size, int pageAddr,
+	    char *into)
+{
+    int start = max(addr, pageAddr);
+    int end = min(addr + size, pageAddr + PageSize);
+
+    if (start >= end)
+	return FALSE;
+    file->ReadAt(into + (start - pageAddr), end - start,
+		 inFile + (start - addr));
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// ExecFile::ReadPage
+// 	Fill in "into" with the contents of page "virtualPage" at the
+//	time the program was loaded.  Returns FALSE if nothing had to be
+//	read, because the page is all bss or stack; otherwise, the read
+//	takes DiskTicks.
+//----------------------------------------------------------------------
+
+bool
+ExecFile::ReadPage(int virtualPage, char *into)
+{
+    int pageAddr = virtualPage * PageSize;
+    bool code, data;
+
+    bzero(into, PageSize);
+    code = ReadSegment(file, codeAddr, codeInFile, codeSize, pageAddr, into);
+    data = ReadSegment(file, dataAddr, dataInFile, dataSize, pageAddr, into);
+    if (code || data)
+	interrupt->Delay(DiskTicks);
+    return code || data;
+}
+
+//----------------------------------------------------------------------
+// ExecFile::IsText
+// 	Return TRUE if page "virtualPage" is program text: all of it is
+//	code.  A page that also holds some data, bss or stack may be
+//	written to.
+//----------------------------------------------------------------------
+
+bool
+ExecFile::IsText(int virtualPage)
+{
+    int pageAddr = virtualPage * PageSize;
+
+    return pageAddr >= codeAddr && pageAddr + PageSize <= codeAddr + codeSize;
+}
@@ -0,0 +1,59 @@
+// execfile.h
+//	Data structures for paging a program in from its executable.
+//
+//	A process keeps the NOFF file it was loaded from open, and a
+//	page it hasn't written to swap yet is filled, when it is first
+//	touched, from the code and initialized data segments of the file
+//	(and zeroes for whatever else is in the page).  So a clean page
+//	can simply be dropped when it is evicted.
+//
+//	A forked process runs the same program, so it shares its
+//	parent's ExecFile, and so does a process started (by Exec) from
+//	the same file name as one still running; the file is closed when
+//	the last process using it goes away.  Pages of program text --
+//	those holding nothing but code -- are read-only, and the
+//	VirtualMemoryManager lets all the processes sharing an ExecFile
+//	share the frames holding them.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef EXECFILE_H
+#define EXECFILE_H
+
+#include "copyright.h"
+#include "filesys.h"
+
+struct noffHeader;
+
+class ExecFile {
+  public:
+    ExecFile(char *fileName, OpenFile *executable,
+	     struct noffHeader *noffH);	// Page in from "executable", which
+					// we now own, opened as "fileName"
+    ~ExecFile();			// Close the file
+
+    static ExecFile *Find(char *fileName);
+					// The ExecFile of a running program
+					// called "fileName", or NULL
+
+    ExecFile *Share() { refs++; return this; }
+					// Another process uses us too
+    void Release();			// One less process uses us; 
+					// delete us with the last one
+
+    bool ReadPage(int virtualPage, char *into);
+					// Fill in a page as it was loaded;
+					// FALSE if it is all zeroes
+    bool IsText(int virtualPage);	// Is the page all code?
+
+  private:
+    char *name;				// the file it was opened as
+    OpenFile *file;			// the NOFF file
+    int codeAddr, codeInFile, codeSize;	// where its segments go
+    int dataAddr, dataInFile, dataSize;
+    int refs;				// processes using the file
+};
+
+#endif // EXECFILE_H
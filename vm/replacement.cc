@@ -0,0 +1,343 @@
+// replacement.cc
+//	Routines for the page replacement policies.  See replacement.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "replacement.h"
+#include "virtualmemorymanager.h"
+
+//----------------------------------------------------------------------
+// NewReplacementPolicy
+// 	Create the policy called "name" (as given after -vm), to manage
+//	the frames of "manager".  Returns NULL if we don't know it.
+//----------------------------------------------------------------------
+
+ReplacementPolicy *
+NewReplacementPolicy(char *name, VirtualMemoryManager *manager)
+{
+    if (!strcmp(name, "clock"))
+	return new ClockPolicy(manager);
+    if (!strcmp(name, "wsclock"))
+	return new WSClockPolicy(manager);
+    if (!strcmp(name, "aging"))
+	return new AgingPolicy(manager);
+    if (!strcmp(name, "2q"))
+	return new TwoQPolicy(manager);
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// ReplacementPolicy::ReplacementPolicy
+// 	Start counting from zero.
+//----------------------------------------------------------------------
+
+ReplacementPolicy::ReplacementPolicy(VirtualMemoryManager *manager)
+{
+    vmm = manager;
+    hits = misses = 0;
+}
+
+//----------------------------------------------------------------------
+// ReplacementPolicy::Print
+// 	Print the counters every policy keeps.  A hit here is a page
+//	fault on a page some other process already had in memory.
+//----------------------------------------------------------------------
+
+void
+ReplacementPolicy::Print()
+{
+    printf("Replacement (%s): hits %d, misses %d", Name(), hits, misses);
+}
+
+//----------------------------------------------------------------------
+// ClockPolicy
+// 	Second chance: sweep the hand over the frames in use, clearing
+//	use bits, and take the first frame whose pages weren't used.
+//----------------------------------------------------------------------
+
+ClockPolicy::ClockPolicy(VirtualMemoryManager *manager)
+    : ReplacementPolicy(manager)
+{
+    hand = 0;
+    secondChances = 0;
+}
+
+int
+ClockPolicy::ChooseVictim()
+{
+    while (TRUE) {
+	int frame = hand;
+	hand = (hand + 1) % NumPhysPages;
+
+	if (!vmm->frameInUse(frame))
+	    continue;
+	if (vmm->testAndClearUse(frame)) {
+	    secondChances++;
+	    continue;
+	}
+	return frame;
+    }
+}
+
+void
+ClockPolicy::Print()
+{
+    ReplacementPolicy::Print();
+    printf(", second chances %d\n", secondChances);
+}
+
+//----------------------------------------------------------------------
+// WSClockPolicy
+// 	Like the clock, but a frame that wasn't used is only taken if
+//	it is also older than WSClockTau, and clean.  Old dirty pages
+//	are written back as the hand passes them, so they are clean by
+//	the time it comes round again.  If a whole turn finds nothing,
+//	take the first unused clean page seen, or failing that, the
+//	first unused page.
+//----------------------------------------------------------------------
+
+WSClockPolicy::WSClockPolicy(VirtualMemoryManager *manager)
+    : ReplacementPolicy(manager)
+{
+    hand = 0;
+    referenced = cleaned = 0;
+    for (int i = 0; i < NumPhysPages; i++)
+	lastUse[i] = 0;
+}
+
+void
+WSClockPolicy::PageIn(int frame)
+{
+    ReplacementPolicy::PageIn(frame);
+    lastUse[frame] = stats->totalTicks;
+}
+
+int
+WSClockPolicy::ChooseVictim()
+{
+    int now = stats->totalTicks;
+    int firstClean = -1, firstUnused = -1;
+
+    for (int i = 0; i < 2 * NumPhysPages; i++) {
+	int frame = hand;
+	hand = (hand + 1) % NumPhysPages;
+
+	if (!vmm->frameInUse(frame))
+	    continue;
+	if (vmm->testAndClearUse(frame)) {
+	    referenced++;
+	    lastUse[frame] = now;
+	    continue;
+	}
+	if (firstUnused == -1)
+	    firstUnused = frame;
+	if (vmm->frameDirty(frame)) {
+	    if (now - lastUse[frame] > WSClockTau) {
+		vmm->cleanFrame(frame);
+		cleaned++;
+	    }
+	    continue;
+	}
+	if (now - lastUse[frame] > WSClockTau)
+	    return frame;
+	if (firstClean == -1)
+	    firstClean = frame;
+    }
+    if (firstClean != -1)
+	return firstClean;
+    if (firstUnused != -1)
+	return firstUnused;
+
+    // Everything was in use; the use bits are all clear now
+    while (!vmm->frameInUse(hand))
+	hand = (hand + 1) % NumPhysPages;
+    return hand;
+}
+
+void
+WSClockPolicy::Print()
+{
+    ReplacementPolicy::Print();
+    printf(", referenced %d, written back early %d\n", referenced, cleaned);
+}
+
+//----------------------------------------------------------------------
+// AgingPolicy
+// 	Every time a victim is needed, shift every frame's counter right
+//	and put its use bit in at the top; the frame with the smallest
+//	counter has gone unused the longest, roughly.  The counters are
+//	only aged then, not on every timer tick as in a real kernel, so
+//	"longest" is measured in evictions rather than in time.
+//----------------------------------------------------------------------
+
+AgingPolicy::AgingPolicy(VirtualMemoryManager *manager)
+    : ReplacementPolicy(manager)
+{
+    referenced = 0;
+    for (int i = 0; i < NumPhysPages; i++)
+	age[i] = 0;
+}
+
+void
+AgingPolicy::PageIn(int frame)
+{
+    ReplacementPolicy::PageIn(frame);
+    age[frame] = 0;
+}
+
+int
+AgingPolicy::ChooseVictim()
+{
+    int victim = -1;
+
+    for (int frame = 0; frame < NumPhysPages; frame++) {
+	if (!vmm->frameInUse(frame))
+	    continue;
+	age[frame] >>= 1;
+	if (vmm->testAndClearUse(frame)) {
+	    referenced++;
+	    age[frame] |= 1 << (AgingBits - 1);
+	}
+	if (victim == -1 || age[frame] < age[victim])
+	    victim = frame;
+    }
+    ASSERT(victim != -1);
+    return victim;
+}
+
+void
+AgingPolicy::Print()
+{
+    ReplacementPolicy::Print();
+    printf(", referenced %d\n", referenced);
+}
+
+//----------------------------------------------------------------------
+// TwoQPolicy
+// 	A page faulted in for the first time goes on A1in, a FIFO queue.
+//	When it is evicted from there, we remember it for a while in
+//	A1out; if it is faulted in again while still remembered, it has
+//	proven itself, and goes on Am, which is run as a clock.  Victims
+//	come from A1in while it is over its share, else from Am.
+//
+//	A1out remembers pages by address space, so when a space goes
+//	away its pages are forgotten; otherwise a new space that happened
+//	to get the same address would seem to fault them in again.
+//----------------------------------------------------------------------
+
+TwoQPolicy::TwoQPolicy(VirtualMemoryManager *manager)
+    : ReplacementPolicy(manager)
+{
+    for (int i = 0; i < NumPhysPages; i++) {
+	queue[i] = None;
+	loadedAt[i] = 0;
+	ghostSpace[i] = NULL;
+	ghostPage[i] = -1;
+    }
+    numIn = loads = hand = 0;
+    ghostNext = ghostHits = 0;
+}
+
+int
+TwoQPolicy::GhostSlot(AddrSpace *space, int page)
+{
+    for (int i = 0; i < NumPhysPages / TwoQOutFraction; i++)
+	if (ghostSpace[i] == space && ghostPage[i] == page)
+	    return i;
+    return -1;
+}
+
+int
+TwoQPolicy::OldestIn()
+{
+    int oldest = -1;
+
+    for (int frame = 0; frame < NumPhysPages; frame++)
+	if (queue[frame] == In &&
+		(oldest == -1 || loadedAt[frame] < loadedAt[oldest]))
+	    oldest = frame;
+    return oldest;
+}
+
+void
+TwoQPolicy::PageIn(int frame)
+{
+    AddrSpace *space;
+    int page, slot;
+
+    ReplacementPolicy::PageIn(frame);
+    Freed(frame);			// in case we weren't told
+    vmm->frameOwner(frame, &space, &page);
+    slot = GhostSlot(space, page);
+    if (slot != -1) {
+	ghostHits++;
+	ghostSpace[slot] = NULL;
+	queue[frame] = Main;
+    } else {
+	queue[frame] = In;
+	loadedAt[frame] = loads++;
+	numIn++;
+    }
+}
+
+void
+TwoQPolicy::Evicted(int frame)
+{
+    if (queue[frame] == In) {
+	vmm->frameOwner(frame, &ghostSpace[ghostNext], &ghostPage[ghostNext]);
+	ghostNext = (ghostNext + 1) % (NumPhysPages / TwoQOutFraction);
+    }
+    Freed(frame);
+}
+
+void
+TwoQPolicy::Freed(int frame)
+{
+    if (queue[frame] == In)
+	numIn--;
+    queue[frame] = None;
+}
+
+void
+TwoQPolicy::SpaceFreed(AddrSpace *space)
+{
+    for (int i = 0; i < NumPhysPages / TwoQOutFraction; i++)
+	if (ghostSpace[i] == space)
+	    ghostSpace[i] = NULL;
+}
+
+int
+TwoQPolicy::ChooseVictim()
+{
+    int frame;
+
+    if (numIn > NumPhysPages / TwoQInFraction || numIn == NumPhysPages) {
+	frame = OldestIn();
+	vmm->testAndClearUse(frame);
+	return frame;
+    }
+    for (int i = 0; i < 2 * NumPhysPages; i++) {
+	frame = hand;
+	hand = (hand + 1) % NumPhysPages;
+	if (queue[frame] != Main)
+	    continue;
+	if (!vmm->testAndClearUse(frame))
+	    return frame;
+    }
+    // Am is empty, or became so; fall back on A1in
+    frame = OldestIn();
+    ASSERT(frame != -1);
+    vmm->testAndClearUse(frame);
+    return frame;
+}
+
+void
+TwoQPolicy::Print()
+{
+    ReplacementPolicy::Print();
+    printf(", hits in A1out %d\n", ghostHits);
+}
@@ -0,0 +1,163 @@
+// replacement.h
+//	Page replacement policies: how the VirtualMemoryManager picks the
+//	frame to evict when it needs a free one.
+//
+//	The policies only see what the hardware gives us -- the use bit
+//	of each page, which the VirtualMemoryManager reads (and clears)
+//	for them -- plus being told each time a frame is filled, emptied
+//	or evicted.  The policy to use is chosen with "-vm <policy>":
+//
+//	  clock    second chance, with one hand over all the frames
+//	  wsclock  clock over the frames, evicting clean pages that
+//		   haven't been used for WSClockTau ticks, and writing
+//		   old dirty ones back as it passes them
+//	  aging    an 8-bit counter per frame, shifted right and fed
+//		   with the use bit each time a victim is needed; the
+//		   lowest goes
+//	  2q	   pages start out in a FIFO queue (A1in), and only move
+//		   to the main, clock-managed queue (Am) if they are
+//		   faulted in again soon after being evicted (while still
+//		   remembered in the ghost queue A1out)
+//
+//	Each policy counts its hits and misses: a miss is a page that
+//	had to be read in; what counts as a hit depends on the policy
+//	(see Print).
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef REPLACEMENT_H
+#define REPLACEMENT_H
+
+#include "copyright.h"
+#include "machine.h"
+
+class AddrSpace;
+class VirtualMemoryManager;
+
+#define WSClockTau	5000		// ticks before a page is "old"
+#define AgingBits	8		// width of the aging counters
+#define TwoQInFraction	4		// A1in holds 1/4 of the frames,
+#define TwoQOutFraction	2		// and A1out remembers 1/2 of them
+
+// The interface all policies provide.
+class ReplacementPolicy {
+  public:
+    ReplacementPolicy(VirtualMemoryManager *manager);
+    virtual ~ReplacementPolicy() {}
+
+    virtual char *Name() = 0;		// as given after -vm
+    virtual int ChooseVictim() = 0;	// A frame in use, to evict
+
+    virtual void PageIn(int frame) { misses++; }
+    					// "frame" was just filled from
+					// swap or the executable
+    virtual void Evicted(int frame) {}	// "frame" is about to be evicted
+    					// (still mapped)
+    virtual void Freed(int frame) {}	// "frame" was freed by its
+    					// process going away
+    virtual void SpaceFreed(AddrSpace *space) {}
+    					// "space" is going away; forget
+					// its pages
+
+    void Hit() { hits++; }		// A page fault was satisfied
+    					// without any I/O
+
+    virtual int GetHand() { return 0; }	// where the scan is; saved in
+    virtual void SetHand(int hand) {}	// checkpoints
+
+    virtual void Print();		// print the counters
+
+  protected:
+    VirtualMemoryManager *vmm;		// whose frames we manage
+    int hits, misses;
+};
+
+// Second chance.
+class ClockPolicy : public ReplacementPolicy {
+  public:
+    ClockPolicy(VirtualMemoryManager *manager);
+
+    char *Name() { return "clock"; }
+    int ChooseVictim();
+    int GetHand() { return hand; }
+    void SetHand(int newHand) { hand = newHand; }
+    void Print();
+
+  private:
+    int hand;				// next frame to look at
+    int secondChances;			// use bits found set
+};
+
+// WSClock: a clock that also looks at how long ago a page was used.
+class WSClockPolicy : public ReplacementPolicy {
+  public:
+    WSClockPolicy(VirtualMemoryManager *manager);
+
+    char *Name() { return "wsclock"; }
+    int ChooseVictim();
+    void PageIn(int frame);
+    int GetHand() { return hand; }
+    void SetHand(int newHand) { hand = newHand; }
+    void Print();
+
+  private:
+    int hand;				// next frame to look at
+    int lastUse[NumPhysPages];		// when each was last seen in use
+    int referenced;			// use bits found set
+    int cleaned;			// dirty pages written back early
+};
+
+// Aging counters, an approximation of LRU.
+class AgingPolicy : public ReplacementPolicy {
+  public:
+    AgingPolicy(VirtualMemoryManager *manager);
+
+    char *Name() { return "aging"; }
+    int ChooseVictim();
+    void PageIn(int frame);
+    void Print();
+
+  private:
+    unsigned int age[NumPhysPages];	// the counters
+    int referenced;			// use bits found set
+};
+
+// 2Q, with the main queue run as a clock.
+class TwoQPolicy : public ReplacementPolicy {
+  public:
+    TwoQPolicy(VirtualMemoryManager *manager);
+
+    char *Name() { return "2q"; }
+    int ChooseVictim();
+    void PageIn(int frame);
+    void Evicted(int frame);
+    void Freed(int frame);
+    void SpaceFreed(AddrSpace *space);
+    void Print();
+
+  private:
+    int OldestIn();			// head of A1in, or -1
+    int GhostSlot(AddrSpace *space, int page);
+    					// where A1out remembers a page, or -1
+
+    enum { None, In, Main } queue[NumPhysPages];
+					// which queue each frame is on
+    int loadedAt[NumPhysPages];		// A1in order
+    int numIn;				// frames on A1in
+    int loads;				// to number them
+    int hand;				// clock over Am
+
+    AddrSpace *ghostSpace[NumPhysPages];	// A1out: recently evicted
+    int ghostPage[NumPhysPages];		// pages, oldest first from
+    int ghostNext;				// ghostNext, round robin
+    int ghostHits;			// faults on pages in A1out
+};
+
+extern ReplacementPolicy *NewReplacementPolicy(char *name,
+					       VirtualMemoryManager *manager);
+					// The policy called "name", or
+					// NULL if there's no such thing
+
+#endif // REPLACEMENT_H
@@ -0,0 +1,284 @@
+// swapmanager.cc
+//	Routines to manage the swap file, in extents of consecutive
+//	slots.  See swapmanager.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "swapmanager.h"
+
+//----------------------------------------------------------------------
+// SwapManager::SwapManager
+// 	Create the swap file "name", with room for SwapInitialSlots
+//	pages, all of them free.
+//----------------------------------------------------------------------
+
+SwapManager::SwapManager(char *name)
+{
+    fileName = name;
+    fileSystem->Create(fileName, SwapInitialSlots * PageSize);
+    file = fileSystem->Open(fileName);
+    ASSERT(file != NULL);
+
+    numSlots = SwapInitialSlots;
+    refs = new int[numSlots];
+    extentOf = new SwapExtent *[numSlots];
+    for (int i = 0; i < numSlots; i++) {
+	refs[i] = 0;
+	extentOf[i] = NULL;
+    }
+    spill = NULL;
+    slotsInUse = maxSlotsInUse = 0;
+    numReserved = numSpilled = 0;
+}
+
+//----------------------------------------------------------------------
+// SwapManager::~SwapManager
+// 	Throw away the swap file, and the extents of the processes still
+//	running when the machine halts.
+//----------------------------------------------------------------------
+
+SwapManager::~SwapManager()
+{
+    for (int i = 0; i < numSlots; i++)
+	if (extentOf[i] != NULL && extentOf[i]->first == i)
+	    delete extentOf[i];
+    delete [] refs;
+    delete [] extentOf;
+    delete file;
+    fileSystem->Remove(fileName);
+}
+
+//----------------------------------------------------------------------
+// SwapManager::Reserve
+// 	Reserve "size" consecutive slots for an address space of "size"
+//	pages, growing the swap file if there's no room for them.
+//----------------------------------------------------------------------
+
+SwapExtent *
+SwapManager::Reserve(int size)
+{
+    SwapExtent *extent = new SwapExtent;
+
+    ASSERT(size > 0);
+    extent->first = FindRun(size);
+    extent->size = size;
+    extent->inUse = 0;
+    extent->owned = TRUE;
+    for (int i = 0; i < size; i++)
+	extentOf[extent->first + i] = extent;
+    numReserved++;
+
+    DEBUG('v', "Swap extent of %d slots at %d\n", size, extent->first);
+    return extent;
+}
+
+//----------------------------------------------------------------------
+// SwapManager::Close
+// 	The process that reserved "extent" has exited.  Its slots still
+//	holding pages (shared with processes it forked) are kept until
+//	those let go of them; the whole extent is freed then.
+//----------------------------------------------------------------------
+
+void
+SwapManager::Close(SwapExtent *extent)
+{
+    if (extent == NULL)
+	return;			// it never needed any swap
+    extent->owned = FALSE;
+    if (extent->inUse == 0)
+	Free(extent);
+}
+
+//----------------------------------------------------------------------
+// SwapManager::Alloc
+// 	Find a slot for page "page" of the process that reserved
+//	"extent": slot "page" of the extent, unless that still holds an
+//	earlier version of the page, shared with other processes, in
+//	which case one from the spill extent.
+//
+//	Returns the location of the slot in the swap file.
+//----------------------------------------------------------------------
+
+int
+SwapManager::Alloc(SwapExtent *extent, int page)
+{
+    int slot = extent->first + page;
+
+    ASSERT(page >= 0 && page < extent->size);
+    if (refs[slot] != 0) {
+	slot = -1;
+	if (spill != NULL)
+	    for (int i = 0; i < spill->size && slot == -1; i++)
+		if (refs[spill->first + i] == 0)
+		    slot = spill->first + i;
+	if (slot == -1) {
+	    spill = Reserve(SwapSpillSlots);
+	    spill->owned = FALSE;
+	    slot = spill->first;
+	}
+	numSpilled++;
+    }
+
+    refs[slot] = 1;
+    extentOf[slot]->inUse++;
+    if (++slotsInUse > maxSlotsInUse)
+	maxSlotsInUse = slotsInUse;
+    return slot * PageSize;
+}
+
+//----------------------------------------------------------------------
+// SwapManager::Share
+// 	Record that another page refers to the slot at "location".
+//----------------------------------------------------------------------
+
+void
+SwapManager::Share(int location)
+{
+    ASSERT(refs[location / PageSize] > 0);
+    refs[location / PageSize]++;
+}
+
+//----------------------------------------------------------------------
+// SwapManager::Release
+// 	Record that one less page refers to the slot at "location".
+//	Once nothing does, the slot is free; and once all of the slots
+//	of an extent nobody owns any more are free, so is the extent.
+//----------------------------------------------------------------------
+
+void
+SwapManager::Release(int location)
+{
+    int slot = location / PageSize;
+    SwapExtent *extent = extentOf[slot];
+
+    ASSERT(refs[slot] > 0);
+    if (--refs[slot] > 0)
+	return;
+    slotsInUse--;
+    if (--extent->inUse == 0 && !extent->owned) {
+	if (extent == spill)
+	    spill = NULL;
+	Free(extent);
+    }
+}
+
+//----------------------------------------------------------------------
+// SwapManager::Refs
+// 	Return how many pages refer to the slot at "location".
+//----------------------------------------------------------------------
+
+int
+SwapManager::Refs(int location)
+{
+    return refs[location / PageSize];
+}
+
+//----------------------------------------------------------------------
+// SwapManager::Read
+// SwapManager::Write
+// 	Transfer "size" bytes (a whole number of pages) between memory
+//	and the slots starting at "location", taking DiskTicks of
+//	simulated time per page.
+//----------------------------------------------------------------------
+
+void
+SwapManager::Read(char *into, int size, int location)
+{
+    ASSERT(location >= 0 && location + size <= numSlots * PageSize);
+    file->ReadAt(into, size, location);
+    interrupt->Delay(size / PageSize * DiskTicks);
+}
+
+void
+SwapManager::Write(char *from, int size, int location)
+{
+    ASSERT(location >= 0 && location + size <= numSlots * PageSize);
+    file->WriteAt(from, size, location);
+    interrupt->Delay(size / PageSize * DiskTicks);
+}
+
+//----------------------------------------------------------------------
+// SwapManager::Print
+// 	Print how big the swap file had to get.
+//----------------------------------------------------------------------
+
+void
+SwapManager::Print()
+{
+    printf("Swap: %d slots, at most %d in use, %d extents reserved, "
+	   "%d pages spilled\n", numSlots, maxSlotsInUse, numReserved,
+	   numSpilled);
+}
+
+//----------------------------------------------------------------------
+// SwapManager::FindRun
+// 	Return the first of "size" consecutive free slots (the first
+//	such run, so that the file grows as little as possible).  If
+//	there is none, grow the file, starting the run in any free slots
+//	left at its end.
+//----------------------------------------------------------------------
+
+int
+SwapManager::FindRun(int size)
+{
+    int run = 0;
+
+    for (int slot = 0; slot < numSlots; slot++) {
+	if (extentOf[slot] != NULL)
+	    run = 0;
+	else if (++run == size)
+	    return slot - size + 1;
+    }
+    Grow(numSlots - run + size);
+    return numSlots - run;
+}
+
+//----------------------------------------------------------------------
+// SwapManager::Grow
+// 	Make room for at least "atLeast" slots, doubling the size of the
+//	swap file if that's enough.  The new slots are free.
+//----------------------------------------------------------------------
+
+void
+SwapManager::Grow(int atLeast)
+{
+    int newSlots = max(2 * numSlots, atLeast);
+    int *newRefs = new int[newSlots];
+    SwapExtent **newExtentOf = new SwapExtent *[newSlots];
+    int i;
+
+    for (i = 0; i < numSlots; i++) {
+	newRefs[i] = refs[i];
+	newExtentOf[i] = extentOf[i];
+    }
+    for (; i < newSlots; i++) {
+	newRefs[i] = 0;
+	newExtentOf[i] = NULL;
+    }
+    delete [] refs;
+    delete [] extentOf;
+    refs = newRefs;
+    extentOf = newExtentOf;
+
+    DEBUG('v', "Swap grown from %d to %d slots\n", numSlots, newSlots);
+    numSlots = newSlots;
+}
+
+//----------------------------------------------------------------------
+// SwapManager::Free
+// 	Give the slots of "extent" back; none of them may be in use.
+//----------------------------------------------------------------------
+
+void
+SwapManager::Free(SwapExtent *extent)
+{
+    for (int i = 0; i < extent->size; i++) {
+	ASSERT(refs[extent->first + i] == 0);
+	extentOf[extent->first + i] = NULL;
+    }
+    delete extent;
+}
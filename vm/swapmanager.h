@@ -0,0 +1,91 @@
+// swapmanager.h
+//	Data structures for managing the swap file, where the
+//	VirtualMemoryManager keeps the pages it evicts.
+//
+//	The swap file is divided into page-sized slots.  Rather than
+//	handing out slots one at a time, wherever there is a free one,
+//	each second-level page table of an address space reserves an
+//	extent -- a run of consecutive slots, one per page -- the first
+//	time one of its pages is written out, and its page N always goes
+//	to slot N of the extent.  So pages that are next to each other in
+//	memory are next to each other in swap, and can be read in with a
+//	single request (see VirtualMemoryManager::loadPages); the parts
+//	of the address space never used take no swap; and when the
+//	process exits, its extents are freed at once.
+//
+//	A slot can hold a page shared copy-on-write by several processes
+//	(see VirtualMemoryManager::shareAddrSpace), so each slot counts
+//	the pages referring to it, and an extent is only freed once its
+//	owner has gone away and no page refers to any of its slots.  A
+//	page whose own slot is still in use that way, when it needs one,
+//	gets a slot from a "spill" extent, shared by all processes.
+//
+//	The file starts out with room for SwapInitialSlots pages, and
+//	grows (at least doubling) whenever an extent doesn't fit.  It
+//	grows just by being written past its end, as the stub file
+//	system -- which is what the VM assignment is built with -- allows.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SWAPMANAGER_H
+#define SWAPMANAGER_H
+
+#include "copyright.h"
+#include "filesys.h"
+
+#define SwapInitialSlots	512	// pages the swap file has room for
+					// to start with
+#define SwapSpillSlots		16	// size of a spill extent
+
+// A run of consecutive slots in the swap file.
+class SwapExtent {
+  public:
+    int first;			// first slot
+    int size;			// number of slots
+    int inUse;			// slots holding a page
+    bool owned;			// still reserved by a running process;
+				// FALSE for spill extents
+};
+
+class SwapManager {
+  public:
+    SwapManager(char *name);		// Create the swap file "name"
+    ~SwapManager();			// Remove it
+
+    SwapExtent *Reserve(int size);	// Reserve "size" consecutive slots
+    void Close(SwapExtent *extent);	// The process that reserved "extent"
+					// has gone away
+
+    int Alloc(SwapExtent *extent, int page);
+					// A slot for page "page" of the
+					// process owning "extent"; returns
+					// its location in the file
+    void Share(int location);		// Another page refers to a slot
+    void Release(int location);		// One less page refers to it
+    int Refs(int location);		// How many pages refer to it
+
+    void Read(char *into, int size, int location);
+    void Write(char *from, int size, int location);
+
+    void Print();			// Print how big swap got
+
+  private:
+    int FindRun(int size);		// First of "size" free slots,
+					// growing the file if need be
+    void Grow(int atLeast);		// Make room for "atLeast" slots
+    void Free(SwapExtent *extent);	// Give "extent" back
+
+    char *fileName;
+    OpenFile *file;
+    int numSlots;			// how many slots the file has now
+    int *refs;				// pages referring to each slot
+    SwapExtent **extentOf;		// the extent each slot is in, or NULL
+    SwapExtent *spill;			// spill extent being filled, or NULL
+
+    int slotsInUse, maxSlotsInUse;	// statistics
+    int numReserved, numSpilled;
+};
+
+#endif // SWAPMANAGER_H
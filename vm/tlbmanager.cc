@@ -0,0 +1,195 @@
+// tlbmanager.cc
+//	Routines to manage the software-loaded TLB.  See tlbmanager.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "tlbmanager.h"
+#include "addrspace.h"
+
+//----------------------------------------------------------------------
+// TLBManager::TLBManager
+// 	Start managing the machine's TLB, which is empty, replacing
+//	entries according to the policy called "name" (as given
+//	after -tlbpolicy).
+//----------------------------------------------------------------------
+
+TLBManager::TLBManager(char *name)
+{
+    ASSERT(machine->tlb != NULL);
+    if (!strcmp(name, "fifo"))
+	policy = FIFO;
+    else if (!strcmp(name, "random"))
+	policy = RANDOM;
+    else {
+	if (strcmp(name, "clock"))
+	    fprintf(stderr, "Unknown TLB replacement policy %s, using clock\n",
+		    name);
+	policy = CLOCK;
+	name = "clock";
+    }
+    policyName = name;
+    numEntries = machine->tlbSize;
+    asids = new BitMap(NumASIDs);
+    hand = 0;
+    refills = replaced = flushed = 0;
+}
+
+TLBManager::~TLBManager()
+{
+    delete asids;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::NewASID
+// 	Return an address space ID nobody is using.
+//----------------------------------------------------------------------
+
+int
+TLBManager::NewASID()
+{
+    int asid = asids->Find();
+
+    ASSERT(asid != -1);
+    return asid;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::FreeASID
+// 	The address space with ID "asid" has gone away: forget its
+//	translations, so the ID can be given to another.
+//----------------------------------------------------------------------
+
+void
+TLBManager::FreeASID(int asid)
+{
+    FlushASID(asid);
+    asids->Clear(asid);
+}
+
+//----------------------------------------------------------------------
+// TLBManager::Refill
+// 	Handle a TLB miss on page "vpn" of "space" (the running process)
+//	by loading the translation from its page table, if the page is
+//	in memory.  If it isn't, the caller has to page it in first.
+//
+//	The entry is read-only until the page has been written to, so
+//	that the first write traps and the page can be marked dirty; the
+//	entry is then reloaded, replacing the read-only one.
+//----------------------------------------------------------------------
+
+void
+TLBManager::Refill(AddrSpace *space, int vpn)
+{
+    TranslationEntry *page;
+    TLBEntry *entry = NULL;
+
+    ASSERT(space->isLegalPage(vpn));
+    page = space->getPageTableEntry(vpn);
+    if (!page->valid)
+	return;			// it'll fault again
+
+    for (int i = 0; i < machine->tlbSize; i++)
+	if (machine->tlb[i].valid && machine->tlb[i].asid == space->asid &&
+		machine->tlb[i].virtualPage == vpn)
+	    entry = &machine->tlb[i];
+    if (entry == NULL) {
+	entry = &machine->tlb[ChooseEntry()];
+	if (entry->valid)
+	    replaced++;
+    }
+
+    entry->virtualPage = vpn;
+    entry->physicalPage = page->physicalPage;
+    entry->readOnly = page->readOnly || !page->dirty;
+    entry->use = FALSE;		// the hardware sets it, when it's used
+    entry->dirty = page->dirty;
+    entry->asid = space->asid;
+    entry->valid = TRUE;
+    page->use = TRUE;
+    refills++;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::FlushPage
+// 	Forget the translation of page "vpn" of the address space with ID
+//	"asid", if it's in the TLB.  Must be called whenever the kernel
+//	invalidates that page, write-protects it, or clears its use or
+//	dirty bit.
+//----------------------------------------------------------------------
+
+void
+TLBManager::FlushPage(int asid, int vpn)
+{
+    for (int i = 0; i < machine->tlbSize; i++)
+	if (machine->tlb[i].valid && machine->tlb[i].asid == asid &&
+		machine->tlb[i].virtualPage == vpn) {
+	    machine->tlb[i].valid = FALSE;
+	    flushed++;
+	}
+}
+
+//----------------------------------------------------------------------
+// TLBManager::FlushASID
+// 	Forget every translation of the address space with ID "asid".
+//----------------------------------------------------------------------
+
+void
+TLBManager::FlushASID(int asid)
+{
+    for (int i = 0; i < machine->tlbSize; i++)
+	if (machine->tlb[i].valid && machine->tlb[i].asid == asid) {
+	    machine->tlb[i].valid = FALSE;
+	    flushed++;
+	}
+}
+
+//----------------------------------------------------------------------
+// TLBManager::Print
+// 	Print how many translations we loaded, how many of them replaced
+//	another, and how many the kernel flushed.  The hits and misses
+//	are counted by the hardware (see Statistics).
+//----------------------------------------------------------------------
+
+void
+TLBManager::Print()
+{
+    printf("TLB (%s, %d entries): refills %d, replaced %d, flushed %d\n",
+	   policyName, numEntries, refills, replaced, flushed);
+}
+
+//----------------------------------------------------------------------
+// TLBManager::ChooseEntry
+// 	Return the entry to load a translation into: an invalid one if
+//	there is any, else the one the policy picks.
+//----------------------------------------------------------------------
+
+int
+TLBManager::ChooseEntry()
+{
+    int size = machine->tlbSize;
+    int entry;
+
+    for (entry = 0; entry < size; entry++)
+	if (!machine->tlb[entry].valid)
+	    return entry;
+
+    switch (policy) {
+      case RANDOM:
+	return Random() % size;
+      case CLOCK:
+	while (machine->tlb[hand].use) {
+	    machine->tlb[hand].use = FALSE;
+	    hand = (hand + 1) % size;
+	}
+	break;
+      default:
+	break;
+    }
+    entry = hand;
+    hand = (hand + 1) % size;
+    return entry;
+}
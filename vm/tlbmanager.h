@@ -0,0 +1,74 @@
+// tlbmanager.h
+//	Data structures for running user programs with a software-managed
+//	TLB (-tlb <entries>) instead of a linear page table.
+//
+//	The hardware only looks in the TLB; when a translation isn't
+//	there, it raises a PageFaultException, and the kernel loads it
+//	from the running process's page table (Refill).  Most of these
+//	misses are for pages already in memory, and are dealt with without
+//	going anywhere near the VirtualMemoryManager.
+//
+//	Each address space is given an address space ID, which tags its
+//	TLB entries, so a context switch doesn't have to flush the TLB;
+//	the entries of a process are only flushed when it goes away.
+//	Whenever the kernel changes a page table entry, it has to flush
+//	the matching TLB entry (FlushPage), whichever process it belongs to.
+//
+//	The kernel keeps the use and dirty bits of the page tables, which
+//	is where the page replacement policies look: a page's use bit is
+//	set when it is loaded into the TLB (the policies flush the entry
+//	when they clear it), and an entry is loaded read-only until the
+//	page is dirty, so that the first write to it traps.
+//
+//	When there's no free entry, the one to replace is chosen with
+//	"-tlbpolicy <policy>":
+//
+//	  fifo	   round robin
+//	  random   any entry
+//	  clock	   second chance, using the use bits the hardware sets
+//		   in the TLB entries (the default)
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TLBMANAGER_H
+#define TLBMANAGER_H
+
+#include "copyright.h"
+#include "bitmap.h"
+
+class AddrSpace;
+
+#define NumASIDs	64		// address space IDs; more than
+					// MAX_PROCESSES, so there's always
+					// one for a new process
+
+class TLBManager {
+  public:
+    TLBManager(char *policyName);	// Manage the machine's TLB
+    ~TLBManager();
+
+    int NewASID();			// An ID for a new address space
+    void FreeASID(int asid);		// Its process has gone away
+
+    void Refill(AddrSpace *space, int vpn);
+    					// Load the translation of page "vpn"
+					// of "space", the running process
+    void FlushPage(int asid, int vpn);	// Forget the translation of "vpn"
+    void FlushASID(int asid);		// Forget all of them
+
+    void Print();			// Print what we did
+
+  private:
+    int ChooseEntry();			// The entry to replace
+
+    enum { FIFO, RANDOM, CLOCK } policy;
+    char *policyName;			// as given after -tlbpolicy
+    int numEntries;			// size of the TLB
+    BitMap *asids;			// the IDs in use
+    int hand;				// next entry to look at (fifo, clock)
+    int refills, replaced, flushed;	// statistics
+};
+
+#endif // TLBMANAGER_H
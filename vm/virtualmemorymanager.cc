@@ -9,30 +9,109 @@
 #include <machine.h>
 #include "virtualmemorymanager.h"
 #include "system.h"
+#include "replacement.h"
+#include "swapmanager.h"
+#include "execfile.h"
+#include "sysopenfile.h"
 
-VirtualMemoryManager::VirtualMemoryManager()
+VirtualMemoryManager::VirtualMemoryManager(char *policyName)
 {
-    fileSystem->Create(SWAP_FILENAME, SWAP_SECTOR_SIZE * SWAP_SECTORS);
-    swapFile = fileSystem->Open(SWAP_FILENAME);
-
-    swapSectorMap = new BitMap(SWAP_SECTORS);
+    swap = new SwapManager(SWAP_FILENAME);
     physicalMemoryInfo = new FrameInfo[NumPhysPages];
+    for (int i = 0; i < NumPhysPages; i++) {
+        physicalMemoryInfo[i].space = NULL;
+        physicalMemoryInfo[i].page = NULL;
+        physicalMemoryInfo[i].next = -1;
+        physicalMemoryInfo[i].refs = 0;
+        physicalMemoryInfo[i].text = NULL;
+        physicalMemoryInfo[i].swapLocation = -1;
+        physicalMemoryInfo[i].file = NULL;
+    }
+    mapSize = NumPhysPages; // grown when a frame is first shared
+    freeMappings = -1;
     //swapSpaceInfo = new SwapSectorInfo[SWAP_SECTORS];
-    nextVictim = 0;
+    policy = NewReplacementPolicy(policyName, this);
+    if (policy == NULL) {
+        fprintf(stderr, "Unknown page replacement policy %s, using clock\n",
+                policyName);
+        policy = new ClockPolicy(this);
+    }
+    pageOutRequest = new Semaphore("page-out request", 0);
+    pageOutPending = FALSE;
+    dedupRequest = NULL;
+    dedupPending = FALSE;
+    nextDedupScan = 0;
+    dedupScans = pagesMerged = 0;
+    spaces = new List;
+    exitedStats = new List;
+    nextResidencySample = 0;
 }
 
 VirtualMemoryManager::~VirtualMemoryManager()
 {
-    fileSystem->Remove(SWAP_FILENAME);
-    delete swapFile;
+    delete swap;
     delete [] physicalMemoryInfo;
+    delete pageOutRequest;
+    delete dedupRequest;
+    delete policy;
+    delete spaces;
+    while (!exitedStats->IsEmpty())
+        delete (PagingStatistics*) exitedStats->Remove();
+    delete exitedStats;
     //delete [] swapSpaceInfo;
 }
 
-int VirtualMemoryManager::allocSwapSector()
+/*
+ * Allocate a swap sector for page "pageTableIndex" of "space", whose
+ * contents are about to be written out: its slot in the swap extent of
+ * the page's second-level page table, which is reserved the first time
+ * one of that table's pages needs one (see swapmanager.h).  So the
+ * unused middle of the address space takes no swap either.  The swap
+ * file grows as needed, so this never fails.
+ */
+int VirtualMemoryManager::allocSwapSlot(AddrSpace* space, int pageTableIndex)
+{
+    SwapExtent** extent = &space->swapExtents[pageTableIndex / PageTableSpan];
+
+    if (*extent == NULL)
+        *extent = swap->Reserve(PageTableSpan);
+    return swap->Alloc(*extent, pageTableIndex % PageTableSpan);
+}
+
+/*
+ * Return where page "pageTableIndex" of "space" is in swap, or -1 if it
+ * isn't.  While the page is in memory, that's kept in the reverse map
+ * entry of its frame, which all the pages mapped to it share; while it
+ * isn't, its page table entry holds it (plus one, so that 0 is "not in
+ * swap") in place of the frame number.
+ */
+int VirtualMemoryManager::getSwapLocation(AddrSpace* space, int pageTableIndex)
+{
+    TranslationEntry* page = space->getPageTableEntry(pageTableIndex);
+
+    if (page->valid)
+        return physicalMemoryInfo[page->physicalPage].swapLocation;
+    if (page->physicalPage == 0)
+        return -1;
+    return (page->physicalPage - 1) * PageSize;
+}
+
+/*
+ * Record that page "pageTableIndex" of "space" is now kept at "location"
+ * in swap (or isn't in swap, if -1).  If the page is in memory, so are
+ * the others sharing its frame.
+ */
+void VirtualMemoryManager::setSwapLocation(AddrSpace* space,
+                                           int pageTableIndex, int location)
 {
-    int location = swapSectorMap->Find() * PageSize; // also marks the bit
-    return location;
+    TranslationEntry* page = space->getPageTableEntry(pageTableIndex);
+
+    if (page->valid)
+        physicalMemoryInfo[page->physicalPage].swapLocation = location;
+    else if (location < 0)
+        page->physicalPage = 0;
+    else
+        page->physicalPage = location / PageSize + 1;
 }
 /*
 SwapSectorInfo * VirtualMemoryManager::getSwapSectorInfo(int index)
@@ -44,147 +123,1093 @@ SwapSectorInfo * VirtualMemoryManager::getSwapSectorInfo(int index)
 void VirtualMemoryManager::writeToSwap(char *page, int pageSize,
                                        int backStoreLoc)
 {
-    swapFile->WriteAt(page, pageSize, backStoreLoc);
+    swap->Write(page, pageSize, backStoreLoc);
 }
 
 /*
- * Page replacement with  the second chance algorithm
+ * Bring the page containing virtAddr of the current process into memory.
+ * A page without a swap sector has never been written, so it is read from
+ * the executable, or zero-filled (see AddrSpace::fillPage).
+ *
+ * If the page's swap sector is shared copy-on-write with another process
+ * that already has it in memory, or it is program text that another process
+ * running the same program has in memory, we just map that frame as well
+ * (read-only).  Otherwise we find a frame, free or by replacement, and read
+ * the page in; it is mapped read-only if it is program text, or if its
+ * sector is still shared, so that the first write to it makes a private
+ * copy.
+ *
+ * When the process seems to be sweeping through its pages in order, the
+ * pages after the faulting one are brought in too (see readAheadPages).
+ *
+ * Pages of mapped files come from the page cache instead (see mapFilePage).
  */
 void VirtualMemoryManager::swapPageIn(int virtAddr)
 {
+        AddrSpace* space = currentThread->space;
+        int pageTableIndex = virtAddr / PageSize;
+        int sector = getSwapLocation(space, pageTableIndex);
+        TranslationEntry* currPageEntry = space->getPageTableEntry(pageTableIndex);
+        ExecFile* text = textOf(space, pageTableIndex);
+        int frame = -1;
 
- //       fprintf(stderr, "virt addr = %d\n",virtAddr); 
- //       printf("trying to swap in\n");
-        TranslationEntry* currPageEntry, victimPageEntry;
-        FrameInfo * physPageInfo;
+        ASSERT(space->isLegalPage(pageTableIndex));
+        MemoryMapping* mapping = space->findMapping(pageTableIndex);
+        if (mapping != NULL) {
+                mapFilePage(space, pageTableIndex, mapping);
+                return;
+        }
 
-        if(memoryManager->getNumFreePages() ==0) {//no more space available
- //               fprintf(stderr, "No more space available - attempting second chance algo\n");
+        if (sector >= 0)
+                frame = findFrameHolding(sector);
+        else if (text != NULL)
+                frame = findTextFrame(text, pageTableIndex);
+
+        if (frame != -1) {
+                policy->Hit();
+                space->getPCB()->paging.faultsShared++;
+                space->readAheadWindow = 0;
+                space->nextSequentialFault = pageTableIndex + 1;
+                addMapping(frame, space, pageTableIndex);
+                currPageEntry->readOnly = TRUE;
+                currPageEntry->dirty = FALSE;
+                currPageEntry->valid = TRUE;
+                return;
+        }
+
+        // The faulting page, and maybe some of those after it
+        frame = getFreeFrame();
+        int count = 1 + readAheadPages(pageTableIndex);
+
+        space->getPCB()->paging.readAheadPages += count - 1;
+
+        for (int i = 0; i < count; i++) {
+                TranslationEntry* page =
+                        space->getPageTableEntry(pageTableIndex + i);
+
+                if (i > 0)
+                        frame = getFreeFrame();
+                sector = getSwapLocation(space, pageTableIndex + i);
+                text = textOf(space, pageTableIndex + i);
+                setFrameOwner(frame, space, pageTableIndex + i, text);
+                page->readOnly = text != NULL ||
+                        (sector >= 0 && swap->Refs(sector) > 1);
+                page->dirty = FALSE;
+                page->use = (i == 0);   // read-ahead pages go first
+        }
+        loadPages(pageTableIndex, count);
+        checkFreeFrames();
+}
+
+/*
+ * Handle a write to a read-only page of the current process, i.e. a page
+ * it shares copy-on-write with a process it forked or was forked from, or
+ * a page of program text.
+ *
+ * If nobody else refers to the page's swap sector any more, the page is
+ * simply made writable.  Otherwise the page gets a swap sector of its own
+ * (text pages get one when they are written out), and, unless it was the
+ * only one using its frame, a frame of its own, with a copy of the shared
+ * contents.
+ */
+void VirtualMemoryManager::copyOnWrite(int virtAddr)
+{
+        AddrSpace* space = currentThread->space;
+        int pageTableIndex = virtAddr / PageSize;
+        int sector = getSwapLocation(space, pageTableIndex);
+        TranslationEntry* page = space->getPageTableEntry(pageTableIndex);
+        int frame = page->physicalPage;
+
+        ASSERT(page->valid && page->readOnly);
+        space->getPCB()->paging.faultsCopyOnWrite++;
+
+        if (sector < 0 || swap->Refs(sector) > 1) {
+                int newSector = -1;
+
+                if (sector >= 0) {
+                        newSector = allocSwapSlot(space, pageTableIndex);
+                        swap->Release(sector);
+                }
+
+                if (physicalMemoryInfo[frame].refs > 1) {
+                        // Others are using the frame; copy it out first,
+                        // since finding a new frame may evict this one.
+                        char contents[PageSize];
+                        bcopy(machine->mainMemory + frame * PageSize, contents,
+                              PageSize);
+                        removeMapping(frame, space, pageTableIndex);
+                        setSwapLocation(space, pageTableIndex, newSector);
+
+                        frame = getFreeFrame();
+                        setFrameOwner(frame, space, pageTableIndex, NULL);
+                        bcopy(contents, machine->mainMemory + frame * PageSize,
+                              PageSize);
+                        machine->InvalidateDecoded(frame * PageSize, PageSize);
+                        page->valid = TRUE;
+                        policy->PageIn(frame);
+                } else {
+                        physicalMemoryInfo[frame].text = NULL;
+                        setSwapLocation(space, pageTableIndex, newSector);
+                }
+                // The new sector hasn't been written yet
+                page->dirty = TRUE;
+        }
 
-                while(true){
+        page->readOnly = FALSE;
+        page->use = TRUE;
+        flushTranslation(space, pageTableIndex);
+        checkFreeFrames();
+}
+
+/*
+ * Share every page of "parent" with the freshly created "child",
+ * copy-on-write: the child refers to the same swap sectors and maps the
+ * same frames, and both sides' pages become read-only.  Dirty pages are
+ * written back first, so that a shared frame always matches its sector.
+ * Pages not in swap yet stay that way, and both sides read them from the
+ * (shared) executable.  Pages of mapped files are left alone: the child
+ * maps the same files, and shares their frames through the page cache.
+ */
+void VirtualMemoryManager::shareAddrSpace(AddrSpace* parent, AddrSpace* child)
+{
+        for (int i = parent->nextAllocatedPage(0); i < parent->getNumPages();
+             i = parent->nextAllocatedPage(i + 1)) {
+                TranslationEntry* parentPage = parent->getPageTableEntry(i);
+                int sector = getSwapLocation(parent, i);
+
+                if (parent->findMapping(i) != NULL)
+                        continue;
+                if (parentPage->valid && parentPage->dirty) {
+                        writePageOut(parent, i);
+                        sector = getSwapLocation(parent, i);
+                }
+                if (sector < 0)
+                        continue;
+                parentPage->readOnly = TRUE;
+
+                TranslationEntry* childPage = child->getPageTableEntry(i);
+                swap->Share(sector);
+                childPage->readOnly = TRUE;
+                if (parentPage->valid) {
+                        addMapping(parentPage->physicalPage, child, i);
+                        childPage->valid = TRUE;
+                } else
+                        setSwapLocation(child, i, sector);
+        }
+        if (parent == currentThread->space)
+                machine->FlushSoftTLB();
+        if (tlbManager != NULL)
+                tlbManager->FlushASID(parent->asid);
+}
+
+/*
+ * Return a frame with nothing in it: a free one if there is any, or else
+ * the one chosen by the replacement policy, after evicting its page.
+ * Normally the page-out daemon keeps some frames free, so we only have to
+ * evict here when it has fallen behind.
+ */
+int VirtualMemoryManager::getFreeFrame()
+{
+        if (memoryManager->getNumFreePages() > 0)
+                return memoryManager->getPage();
+
+        int frame = policy->ChooseVictim();
+        evictFrame(frame);
+        return frame;
+}
+
+/*
+ * Start the page-out daemon, a kernel thread that keeps between
+ * PageOutLow and PageOutHigh frames free, so that a page fault seldom
+ * has to write a page out before it can read one in.
+ */
+static void pageOutDaemon(int arg)
+{
+        virtualMemoryManager->pageOut();
+}
+
+void VirtualMemoryManager::startPageOutDaemon()
+{
+        Thread* daemon = new Thread("page-out daemon");
+        daemon->Fork(pageOutDaemon, 0);
+}
+
+/*
+ * Wake up the page-out daemon if we are running short of free frames.
+ * It runs the next time the faulting thread gives up the CPU.
+ */
+void VirtualMemoryManager::checkFreeFrames()
+{
+        if (!pageOutPending && memoryManager->getNumFreePages() < PageOutLow) {
+                pageOutPending = TRUE;
+                pageOutRequest->V();
+        }
+}
+
+/*
+ * The body of the page-out daemon: each time it's woken up, evict pages,
+ * writing the dirty ones back, until PageOutHigh frames are free.
+ */
+void VirtualMemoryManager::pageOut()
+{
+        while (true) {
+                pageOutRequest->P();
+                while (memoryManager->getNumFreePages() < PageOutHigh) {
+                        int frame = policy->ChooseVictim();
+                        evictFrame(frame);
+                        memoryManager->clearPage(frame);
+                }
+                pageOutPending = FALSE;
+        }
+}
+
+/*
+ * Start the dedup scanner (-dedup), a kernel thread that looks for frames
+ * holding identical pages, and merges them into one, shared copy-on-write
+ * like the pages of a forked process.  It runs every DedupScanTicks,
+ * when checkDedup wakes it up.
+ */
+static void dedupScanner(int arg)
+{
+        virtualMemoryManager->dedupScan();
+}
 
-  //                 fprintf(stderr, "trynna get i = %d\n",nextVictim);
+void VirtualMemoryManager::startDedupScanner()
+{
+        Thread* scanner = new Thread("dedup scanner");
 
-                    FrameInfo * physPageInfo = physicalMemoryInfo + nextVictim;
+        dedupRequest = new Semaphore("dedup request", 0);
+        scanner->Fork(dedupScanner, 0);
+}
 
-   //                 fprintf(stderr, "our pointer is chillin doe but = %d\n",physPageInfo->pageTableIndex);
+/*
+ * Wake up the dedup scanner, if it's running and it's time for another
+ * scan.  Called on every trap into the kernel, like sampleResidency.
+ */
+void VirtualMemoryManager::checkDedup()
+{
+        if (dedupRequest == NULL || dedupPending ||
+            stats->totalTicks < nextDedupScan)
+                return;
+        nextDedupScan = stats->totalTicks + DedupScanTicks;
+        dedupPending = TRUE;
+        dedupRequest->V();
+}
 
-                    TranslationEntry* victimPageEntry = getPageTableEntry(physPageInfo);
+/*
+ * The body of the dedup scanner: each time it's woken up, merge all the
+ * identical pages it can find.
+ */
+void VirtualMemoryManager::dedupScan()
+{
+        while (true) {
+                dedupRequest->P();
+                mergeFrames();
+                dedupScans++;
+                dedupPending = FALSE;
+        }
+}
 
-                    if(victimPageEntry->use){
-  //                      fprintf(stderr, "setting ->use = false\n");
-                        victimPageEntry->use = false;
+/*
+ * Hash the contents of a page (FNV-1a), to find pages that may be the
+ * same without comparing every pair.
+ */
+static unsigned int hashPage(char* page)
+{
+        unsigned int hash = 2166136261u;
 
-                        nextVictim += 1;
-                        nextVictim = nextVictim % NumPhysPages;
+        for (int i = 0; i < PageSize; i++)
+                hash = (hash ^ (unsigned char) page[i]) * 16777619u;
+        return hash;
+}
 
-                    }else{  //this is our vicitm
+/*
+ * Merge every frame holding a single page into an earlier frame with the
+ * same contents, if there is one.  Frames holding program text or pages
+ * of mapped files are left alone; they are shared already.
+ */
+void VirtualMemoryManager::mergeFrames()
+{
+        unsigned int hash[NumPhysPages];
+        bool candidate[NumPhysPages];
 
-                       // fprintf(stderr, "found our victim~~ i = %d\n",nextVictim);                            
-			int l = physPageInfo->space->locationOnDisk[physPageInfo->pageTableIndex];
+        for (int frame = 0; frame < NumPhysPages; frame++) {
+                candidate[frame] = frameInUse(frame) &&
+                        physicalMemoryInfo[frame].text == NULL &&
+                        physicalMemoryInfo[frame].file == NULL;
+                if (candidate[frame])
+                        hash[frame] = hashPage(machine->mainMemory +
+                                               frame * PageSize);
+        }
 
-                        if(victimPageEntry->valid && victimPageEntry->dirty) {
-                            char *physMemLoc = machine->mainMemory + victimPageEntry->physicalPage * PageSize;
-                            writeToSwap(physMemLoc, PageSize, l);
+        for (int from = 0; from < NumPhysPages; from++) {
+                if (!candidate[from] || physicalMemoryInfo[from].refs != 1)
+                        continue;
+                for (int into = 0; into < from; into++)
+                        if (candidate[into] && hash[into] == hash[from] &&
+                            !bcmp(machine->mainMemory + into * PageSize,
+                                  machine->mainMemory + from * PageSize,
+                                  PageSize)) {
+                                mergeFrame(from, into);
+                                candidate[from] = FALSE;
+                                break;
                         }
+        }
+}
 
-                        victimPageEntry->valid = false;
+/*
+ * Move the only page mapped to "from" over to "into", which holds the
+ * same contents, and free "from".  The two pages (or more, if "into" was
+ * shared already) then share a swap slot, and are read-only, so that the
+ * first write to one of them makes it a private copy again (see
+ * copyOnWrite).
+ */
+void VirtualMemoryManager::mergeFrame(int from, int into)
+{
+        FrameInfo* target = physicalMemoryInfo + into;
+        FrameInfo* info = physicalMemoryInfo + from;
+        AddrSpace* space = info->space;
+        int pageTableIndex = info->pageTableIndex;
+        TranslationEntry* page = info->page;
+        int sector = info->swapLocation;
+        int shared;
+
+        // A shared frame always matches its swap slot
+        if (target->refs == 1) {
+                if (target->page->dirty || target->swapLocation < 0)
+                        writePageOut(target->space, target->pageTableIndex);
+                target->page->readOnly = TRUE;
+                flushTranslation(target->space, target->pageTableIndex);
+        }
+        shared = target->swapLocation;
 
-                        physPageInfo->space = currentThread->space;
-                        physPageInfo->pageTableIndex = virtAddr / PageSize;
-                        currPageEntry = getPageTableEntry(physPageInfo);
-                        currPageEntry->physicalPage = nextVictim;
-                     
-                        // Replace page
-                        loadPageToCurrVictim(virtAddr);
-                     
-                        nextVictim += 1;
-                        nextVictim = nextVictim % NumPhysPages;
+        if (sector != shared) {
+                if (sector >= 0)
+                        swap->Release(sector);
+                swap->Share(shared);
+        }
 
-                        return;
+        removeMapping(from, space, pageTableIndex);
+        policy->Freed(from);
+        memoryManager->clearPage(from);
+
+        addMapping(into, space, pageTableIndex);
+        page->valid = TRUE;
+        page->readOnly = TRUE;
+        page->dirty = FALSE;
+        flushTranslation(space, pageTableIndex);
+        pagesMerged++;
+}
+
+/*
+ * Clear the use bit of every page mapped to "frame"; return whether any
+ * of them was set.
+ */
+bool VirtualMemoryManager::testAndClearUse(int frame)
+{
+        bool used = FALSE;
+
+        for (int m = frame; m != -1; m = physicalMemoryInfo[m].next) {
+                FrameInfo* info = physicalMemoryInfo + m;
+                if (info->page->use) {
+                        used = TRUE;
+                        info->page->use = FALSE;
+                        flushTranslation(info->space, info->pageTableIndex);
+                }
+        }
+        return used;
+}
+
+/*
+ * Write the page in "frame" back to its swap sector (or its file) if it
+ * has been modified, and invalidate every mapping of it.
+ */
+void VirtualMemoryManager::evictFrame(int frame)
+{
+        FrameInfo* info = physicalMemoryInfo + frame;
+
+        policy->Evicted(frame);
+
+        // Only an unshared page can be dirty (see shareAddrSpace), unless
+        // it's a page of a mapped file
+        if (frameDirty(frame)) {
+                ASSERT(info->refs == 1 || info->file != NULL);
+                writePageOut(info->space, info->pageTableIndex);
+                info->space->getPCB()->paging.evictionsDirty++;
+        } else
+                info->space->getPCB()->paging.evictionsClean++;
+
+        while (info->space != NULL) {
+                AddrSpace* space = info->space;
+                int pageTableIndex = info->pageTableIndex;
+
+                removeMapping(frame, space, pageTableIndex);
+                flushTranslation(space, pageTableIndex);
+        }
+}
+
+/*
+ * Write page "pageTableIndex" of "space", which is in memory and not
+ * shared, out to its swap sector (giving it one if it has none yet), and
+ * mark it clean.  A page of a mapped file is written back to the file.
+ */
+void VirtualMemoryManager::writePageOut(AddrSpace* space, int pageTableIndex)
+{
+        TranslationEntry* page = space->getPageTableEntry(pageTableIndex);
+        FrameInfo* info = physicalMemoryInfo + page->physicalPage;
+
+        if (info->file != NULL) {
+                writeFilePage(page->physicalPage);
+                return;
+        }
+
+        if (info->swapLocation < 0)
+                info->swapLocation = allocSwapSlot(space, pageTableIndex);
+        writeToSwap(machine->mainMemory + page->physicalPage * PageSize,
+                    PageSize, info->swapLocation);
+        page->dirty = FALSE;
+        space->getPCB()->paging.swapWrites++;
+}
+
+/*
+ * Is "frame" holding a page?
+ */
+bool VirtualMemoryManager::frameInUse(int frame)
+{
+        return physicalMemoryInfo[frame].space != NULL;
+}
+
+/*
+ * Has the page in "frame" been modified since it was read in?  Only the
+ * frame of a mapped file can have more than one page that was.
+ */
+bool VirtualMemoryManager::frameDirty(int frame)
+{
+        for (int m = frame; m != -1; m = physicalMemoryInfo[m].next)
+                if (physicalMemoryInfo[m].page->dirty)
+                        return TRUE;
+        return FALSE;
+}
+
+/*
+ * Which page is in "frame" (the first, if several processes share it).
+ */
+void VirtualMemoryManager::frameOwner(int frame, AddrSpace** space,
+                                      int* pageTableIndex)
+{
+        *space = physicalMemoryInfo[frame].space;
+        *pageTableIndex = physicalMemoryInfo[frame].pageTableIndex;
+}
+
+/*
+ * Write the (dirty, so unshared, unless it's a mapped file's) page in
+ * "frame" back to swap or its file, without evicting it, so that it can be
+ * evicted later without waiting.
+ */
+void VirtualMemoryManager::cleanFrame(int frame)
+{
+        FrameInfo* info = physicalMemoryInfo + frame;
+
+        ASSERT(frameDirty(frame) && (info->refs == 1 || info->file != NULL));
+        writePageOut(info->space, info->pageTableIndex);
+        flushTranslation(info->space, info->pageTableIndex);
+}
+
+/*
+ * Forget any translation of page "pageTableIndex" of "space" the machine
+ * has cached: in the soft TLB, if it's the running process's, and in the
+ * TLB (-tlb), where any process's may be.  Must be called whenever a page
+ * is invalidated, write-protected, or has its use or dirty bit cleared.
+ */
+void VirtualMemoryManager::flushTranslation(AddrSpace* space,
+                                            int pageTableIndex)
+{
+        if (space == currentThread->space)
+                machine->FlushSoftTLBPage(pageTableIndex);
+        if (tlbManager != NULL)
+                tlbManager->FlushPage(space->asid, pageTableIndex);
+}
+
+/*
+ * Print the replacement policy's counters, how big swap got, and what the
+ * dedup scanner did.
+ */
+void VirtualMemoryManager::Print()
+{
+        policy->Print();
+        swap->Print();
+        if (dedupRequest != NULL)
+                printf("Dedup: %d scans, %d pages merged\n", dedupScans,
+                       pagesMerged);
+}
+
+/*
+ * Take a sample of the resident set of every process, and of all of them
+ * together, if it's been ResidencySampleTicks since the last one.  Called
+ * on every trap into the kernel, rather than from a timer interrupt, which
+ * would keep the machine from halting when there's nothing left to run.
+ */
+void VirtualMemoryManager::sampleResidency()
+{
+        if (stats->totalTicks < nextResidencySample)
+                return;
+        nextResidencySample = stats->totalTicks + ResidencySampleTicks;
+
+        for (int i = 0; i < spaces->GetSize(); i++) {
+                AddrSpace* space = (AddrSpace*) spaces->GetElementAt(i);
+                int resident = 0;
+
+                for (int page = space->nextAllocatedPage(0);
+                     page < space->getNumPages();
+                     page = space->nextAllocatedPage(page + 1))
+                        if (space->getPageTableEntry(page)->valid)
+                                resident++;
+                space->getPCB()->paging.SampleResidency(resident);
+        }
+        totals.SampleResidency(NumPhysPages - memoryManager->getNumFreePages());
+}
+
+/*
+ * Write the paging statistics to "fileName", as comma separated values:
+ * a line of column names, one line for each process that has run (in the
+ * order they exited; those still running last), and one for the totals.
+ */
+void VirtualMemoryManager::exportStats(char* fileName)
+{
+        FILE* out = fopen(fileName, "w");
+        PagingStatistics all = totals;
+        int i;
+
+        if (out == NULL) {
+                fprintf(stderr, "Unable to write paging statistics to %s\n",
+                        fileName);
+                return;
+        }
+        PagingStatistics::PrintHeader(out);
+        for (i = 0; i < exitedStats->GetSize(); i++) {
+                PagingStatistics* paging =
+                        (PagingStatistics*) exitedStats->GetElementAt(i);
+                paging->Print(out);
+                all.Add(paging);
+        }
+        for (i = 0; i < spaces->GetSize(); i++) {
+                PCB* pcb = ((AddrSpace*) spaces->GetElementAt(i))->getPCB();
+                pcb->paging.Print(out);
+                all.Add(&pcb->paging);
+        }
+        all.Print(out);
+        fclose(out);
+}
+
+/*
+ * Return the frame holding the page stored in swap "sector", or -1 if it
+ * isn't in memory.
+ */
+int VirtualMemoryManager::findFrameHolding(int sector)
+{
+        if (swap->Refs(sector) <= 1)
+                return -1;      // only the faulting page refers to it
+
+        for (int frame = 0; frame < NumPhysPages; frame++) {
+                FrameInfo* info = physicalMemoryInfo + frame;
+                if (info->space != NULL && info->swapLocation == sector)
+                        return frame;
+        }
+        return -1;
+}
+
+/*
+ * Return the frame holding page "pageTableIndex" of the program "text",
+ * or -1 if no process running it has that page in memory.
+ */
+int VirtualMemoryManager::findTextFrame(ExecFile* text, int pageTableIndex)
+{
+        for (int frame = 0; frame < NumPhysPages; frame++) {
+                FrameInfo* info = physicalMemoryInfo + frame;
+                if (info->text == text && info->pageTableIndex == pageTableIndex)
+                        return frame;
+        }
+        return -1;
+}
+
+/*
+ * If page "pageTableIndex" of "space" is program text, which hasn't been
+ * written to, return the program it belongs to; otherwise NULL.
+ */
+ExecFile* VirtualMemoryManager::textOf(AddrSpace* space, int pageTableIndex)
+{
+        ExecFile* executable = space->getExecutable();
+
+        if (executable == NULL || getSwapLocation(space, pageTableIndex) >= 0 ||
+            !executable->IsText(pageTableIndex))
+                return NULL;
+        return executable;
+}
+
+/*
+ * Bring in page "pageTableIndex" of "space", which is part of "mapping":
+ * if another process mapping the file has the page in memory, we map the
+ * same frame; otherwise we read it from the file into a frame of its own,
+ * which others will share.  Either way the page is writable; the file is
+ * updated when the frame is evicted, or the page unmapped.
+ */
+void VirtualMemoryManager::mapFilePage(AddrSpace* space, int pageTableIndex,
+                                       MemoryMapping* mapping)
+{
+        SysOpenFile* file = mapping->file;
+        int filePage = mapping->filePage + pageTableIndex - mapping->firstPage;
+        TranslationEntry* page = space->getPageTableEntry(pageTableIndex);
+        int frame = findFilePage(file, filePage);
+
+        space->readAheadWindow = 0;
+        if (frame != -1) {
+                policy->Hit();
+                space->getPCB()->paging.faultsShared++;
+                addMapping(frame, space, pageTableIndex);
+        } else {
+                char* into;
+
+                frame = getFreeFrame();
+                setFrameOwner(frame, space, pageTableIndex, NULL);
+                physicalMemoryInfo[frame].file = file;
+                physicalMemoryInfo[frame].filePage = filePage;
+
+                // Past the end of the file, the page reads as zeroes
+                into = machine->mainMemory + frame * PageSize;
+                bzero(into, PageSize);
+                file->file->ReadAt(into, PageSize, filePage * PageSize);
+                interrupt->Delay(DiskTicks);
+                machine->InvalidateDecoded(frame * PageSize, PageSize);
+                space->getPCB()->paging.faultsFile++;
+                policy->PageIn(frame);
+        }
+        page->readOnly = FALSE;
+        page->dirty = FALSE;
+        page->use = TRUE;
+        page->valid = TRUE;
+        checkFreeFrames();
+}
+
+/*
+ * Return the frame holding page "filePage" of the mapped file "file", or
+ * -1 if it isn't in the page cache.
+ */
+int VirtualMemoryManager::findFilePage(SysOpenFile* file, int filePage)
+{
+        for (int frame = 0; frame < NumPhysPages; frame++) {
+                FrameInfo* info = physicalMemoryInfo + frame;
+                if (info->space != NULL && info->file == file &&
+                    info->filePage == filePage)
+                        return frame;
+        }
+        return -1;
+}
+
+/*
+ * Write the mapped file's page in "frame" back to the file, and mark the
+ * pages mapped to it clean.  The file doesn't grow: only the part of the
+ * page that is inside it is written.
+ */
+void VirtualMemoryManager::writeFilePage(int frame)
+{
+        FrameInfo* info = physicalMemoryInfo + frame;
+        OpenFile* file = info->file->file;
+        int position = info->filePage * PageSize;
+        int size = min(PageSize, file->Length() - position);
+
+        if (size > 0) {
+                file->WriteAt(machine->mainMemory + frame * PageSize, size,
+                              position);
+                interrupt->Delay(DiskTicks);
+        }
+        info->space->getPCB()->paging.fileWrites++;
+
+        for (int m = frame; m != -1; m = physicalMemoryInfo[m].next) {
+                FrameInfo* mapping = physicalMemoryInfo + m;
+                if (mapping->page->dirty) {
+                        mapping->page->dirty = FALSE;
+                        flushTranslation(mapping->space,
+                                         mapping->pageTableIndex);
+                }
+        }
+}
+
+/*
+ * The Read syscall: read "size" bytes of "file", from "position" on, into
+ * "into", and return how many there were.  The pages some process has
+ * mapped are copied from the page cache, which may be ahead of the file;
+ * the rest are read from the file, as many at once as possible.
+ */
+int VirtualMemoryManager::readFile(SysOpenFile* file, char* into, int size,
+                                   int position)
+{
+        int done = 0;
+
+        size = max(0, min(size, file->file->Length() - position));
+        while (done < size) {
+                int offset = (position + done) % PageSize;
+                int count = min(PageSize - offset, size - done);
+                int frame = findFilePage(file, (position + done) / PageSize);
+
+                if (frame != -1) {
+                        bcopy(machine->mainMemory + frame * PageSize + offset,
+                              into + done, count);
+                        done += count;
+                        continue;
+                }
+                while (done + count < size &&
+                       findFilePage(file, (position + done + count) /
+                                    PageSize) == -1)
+                        count = min(count + PageSize, size - done);
+                file->file->ReadAt(into + done, count, position + done);
+                done += count;
+        }
+        return size;
+}
+
+/*
+ * The Write syscall: write "size" bytes from "from" into "file", from
+ * "position" on, and return how many were written.  They go straight to
+ * the file, and to the frames of the pages in the page cache as well, so
+ * that the processes mapping them see the change.
+ */
+int VirtualMemoryManager::writeFile(SysOpenFile* file, char* from, int size,
+                                    int position)
+{
+        int written = file->file->WriteAt(from, size, position);
+
+        for (int done = 0; done < written; ) {
+                int offset = (position + done) % PageSize;
+                int count = min(PageSize - offset, written - done);
+                int frame = findFilePage(file, (position + done) / PageSize);
+
+                if (frame != -1) {
+                        bcopy(from + done, machine->mainMemory +
+                              frame * PageSize + offset, count);
+                        machine->InvalidateDecoded(frame * PageSize + offset,
+                                                   count);
+                }
+                done += count;
+        }
+        return written;
+}
+
+/*
+ * Record that "frame", which was free, now holds page "pageTableIndex" of
+ * "space" -- a page of the program "text", or NULL if it isn't text.  The
+ * page isn't valid yet (the caller makes it so once the frame has its
+ * contents); its page table entry gets the frame number, in place of its
+ * swap location, which moves to the frame's reverse map entry.
+ */
+void VirtualMemoryManager::setFrameOwner(int frame, AddrSpace* space,
+                                         int pageTableIndex, ExecFile* text)
+{
+        FrameInfo* info = physicalMemoryInfo + frame;
+        TranslationEntry* page = space->getPageTableEntry(pageTableIndex);
 
-                    }
+        ASSERT(!page->valid);
+        info->space = space;
+        info->pageTableIndex = pageTableIndex;
+        info->page = page;
+        info->next = -1;
+        info->refs = 1;
+        info->text = text;
+        info->swapLocation = getSwapLocation(space, pageTableIndex);
+        info->file = NULL;
+        page->physicalPage = frame;
+}
+
+/*
+ * Record that page "pageTableIndex" of "space" is also mapped to "frame",
+ * and point its page table entry there.  The page must be kept in the
+ * same place in swap as the frame's other pages.
+ */
+void VirtualMemoryManager::addMapping(int frame, AddrSpace* space,
+                                      int pageTableIndex)
+{
+        int mapping = newMapping();     // may move the reverse map
+        FrameInfo* info = physicalMemoryInfo + mapping;
+
+        info->space = space;
+        info->pageTableIndex = pageTableIndex;
+        info->page = space->getPageTableEntry(pageTableIndex);
+        info->next = physicalMemoryInfo[frame].next;
+        physicalMemoryInfo[frame].next = mapping;
+        physicalMemoryInfo[frame].refs++;
+        info->page->physicalPage = frame;
+}
+
+/*
+ * Forget that page "pageTableIndex" of "space" is mapped to "frame": the
+ * page is invalidated, and its page table entry gets back the frame's
+ * swap location.  When the last mapping goes, the frame's entry is left
+ * with a NULL space (and isn't program text, or a file's page, any more).
+ */
+void VirtualMemoryManager::removeMapping(int frame, AddrSpace* space,
+                                         int pageTableIndex)
+{
+        FrameInfo* head = physicalMemoryInfo + frame;
+        int mapping;
 
-                    
-                    
+        space->getPageTableEntry(pageTableIndex)->valid = FALSE;
+        setSwapLocation(space, pageTableIndex, head->swapLocation);
+
+        head->refs--;
+        if (head->space == space && head->pageTableIndex == pageTableIndex) {
+                mapping = head->next;
+                if (mapping == -1) {
+                        head->space = NULL;
+                        head->text = NULL;
+                        head->swapLocation = -1;
+                        head->file = NULL;
+                        return;
                 }
-               // fprintf(stderr, "Fatal error: No more space available\n");
-               // exit(1);
+                head->space = physicalMemoryInfo[mapping].space;
+                head->pageTableIndex = physicalMemoryInfo[mapping].pageTableIndex;
+                head->page = physicalMemoryInfo[mapping].page;
+                head->next = physicalMemoryInfo[mapping].next;
+                freeMapping(mapping);
+                return;
+        }
 
+        for (int prev = frame; physicalMemoryInfo[prev].next != -1;
+             prev = physicalMemoryInfo[prev].next) {
+                FrameInfo* info = physicalMemoryInfo + physicalMemoryInfo[prev].next;
+                if (info->space == space && info->pageTableIndex == pageTableIndex) {
+                        mapping = physicalMemoryInfo[prev].next;
+                        physicalMemoryInfo[prev].next = info->next;
+                        freeMapping(mapping);
+                        return;
+                }
         }
-// printf("free space still avail\n");
-        int freePage = memoryManager->getPage();
- 
-        physPageInfo = physicalMemoryInfo + freePage;
- 
-        physPageInfo->space = currentThread->space;
-        physPageInfo->pageTableIndex = virtAddr / PageSize;
- 
-        // Get translation table entry
-        currPageEntry = getPageTableEntry(physPageInfo);
- 
-        // Find free page in memory
-        currPageEntry->physicalPage = freePage;
- 
-        loadPageToCurrVictim(virtAddr);
-        return;
+        ASSERT(FALSE);
 }
 
+/*
+ * Return an unused entry of the reverse map, past the frames' own, for
+ * another page sharing a frame.  When there is none, the map is doubled
+ * in size -- so pointers into it don't survive a call to this.
+ */
+int VirtualMemoryManager::newMapping()
+{
+        int mapping;
+
+        if (freeMappings == -1) {
+                FrameInfo* old = physicalMemoryInfo;
+                int oldSize = mapSize;
+
+                mapSize *= 2;
+                physicalMemoryInfo = new FrameInfo[mapSize];
+                bcopy((char*) old, (char*) physicalMemoryInfo,
+                      oldSize * sizeof(FrameInfo));
+                delete [] old;
+                for (mapping = mapSize - 1; mapping >= oldSize; mapping--)
+                        freeMapping(mapping);
+        }
+        mapping = freeMappings;
+        freeMappings = physicalMemoryInfo[mapping].next;
+        return mapping;
+}
+
+/*
+ * Put entry "mapping" of the reverse map back on the free list.
+ */
+void VirtualMemoryManager::freeMapping(int mapping)
+{
+        physicalMemoryInfo[mapping].space = NULL;
+        physicalMemoryInfo[mapping].next = freeMappings;
+        freeMappings = mapping;
+}
+
+
+/*
+ * Start keeping track of "space", a new process's address space, for the
+ * paging statistics, and give it an ID for its TLB entries, if there's a
+ * TLB.
+ */
+void VirtualMemoryManager::addAddrSpace(AddrSpace* space)
+{
+    spaces->Append(space);
+    if (tlbManager != NULL)
+        space->asid = tlbManager->NewASID();
+}
 
 /*
  * Cleanup the physical memory allocated to a given address space after its 
- * destructor invokes.
+ * destructor invokes.  Frames and swap sectors still shared with another
+ * process are left to it.  Its process's paging statistics are kept, for
+ * exportStats.
 */
 void VirtualMemoryManager::releasePages(AddrSpace* space)
 {
-//    printf("trying to release here\n");
-    for (int i = 0; i < space->getNumPages(); i++)
+    spaces->Remove(space);
+    exitedStats->Append(new PagingStatistics(space->getPCB()->paging));
+
+    for (int i = space->nextAllocatedPage(0); i < space->getNumPages();
+         i = space->nextAllocatedPage(i + 1))
+        discardPage(space, i);
+    for (int i = 0; i < space->getNumPages() / PageTableSpan; i++)
     {
-        TranslationEntry* currPage = space->getPageTableEntry(i);
-    //  int swapSpaceIndex = (currPage->locationOnDisk) / PageSize;
- //     SwapSectorInfo * swapPageInfo = swapSpaceInfo + swapSpaceIndex;
-//      swapPageInfo->removePage(currPage);
-      //swapPageInfo->pageTableEntry = NULL;
-
-	int l = space->locationOnDisk[i];
-
-        if (currPage->valid == TRUE)
-        {
-            //int currPID = currPage->space->getPCB()->getPID();
-            int currPID = space->getPCB()->getPID();
-            DEBUG('v', "E %d: %d\n", currPID, currPage->virtualPage);
-            memoryManager->clearPage(currPage->physicalPage);
-            physicalMemoryInfo[currPage->physicalPage].space = NULL; 
-        }
-        swapSectorMap->Clear(l / PageSize);
+        swap->Close(space->swapExtents[i]);
+        space->swapExtents[i] = NULL;
     }
+    policy->SpaceFreed(space);
+    if (tlbManager != NULL)
+        tlbManager->FreeASID(space->asid);
 }
 
 /*
- * After selecting a slot of physical memory as a victim and taking care of
- * synchronizing the data if needed, we load the faulting page into memory.
-*/
-void VirtualMemoryManager::loadPageToCurrVictim(int virtAddr)
+ * Drop pages first .. first+count-1 of "space", which it has given back
+ * (see AddrSpace::sbrk and AddrSpace::munmap): free their frames and swap
+ * sectors, unless they are still shared with another process, so that if
+ * they become part of the address space again, they are zero-filled.
+ */
+void VirtualMemoryManager::discardPages(AddrSpace* space, int first, int count)
 {
-  //  printf("trying to load to current vic\n");
+    for (int i = space->nextAllocatedPage(first); i < first + count;
+         i = space->nextAllocatedPage(i + 1))
+    {
+        TranslationEntry* page = space->getPageTableEntry(i);
 
-    int pageTableIndex = virtAddr / PageSize;
+        discardPage(space, i);
+        page->readOnly = FALSE;
+        page->use = FALSE;
+        page->dirty = FALSE;
+        flushTranslation(space, i);
+    }
+}
 
+/*
+ * Let go of the frame and the swap sector of page "pageTableIndex" of
+ * "space", freeing them if no other page refers to them.  A modified page
+ * of a mapped file is written back first.
+ */
+void VirtualMemoryManager::discardPage(AddrSpace* space, int pageTableIndex)
+{
+    TranslationEntry* page = space->getPageTableEntry(pageTableIndex);
+    int location = getSwapLocation(space, pageTableIndex);
 
-    TranslationEntry* page = currentThread->space->getPageTableEntry(pageTableIndex);
-    //printf("tried to get pageTableEntry\n");
-    char* physMemLoc = machine->mainMemory + page->physicalPage * PageSize;
-    int swapSpaceLoc = currentThread->space->locationOnDisk[pageTableIndex];//page->locationOnDisk;
-    //printf("tried to get locationOnDisk\n");
-    swapFile->ReadAt(physMemLoc, PageSize, swapSpaceLoc);
-    //printf("tried to swapFile\n");
+    if (page->valid == TRUE)
+    {
+        int currPID = space->getPCB()->getPID();
+        int frame = page->physicalPage;
+        DEBUG('v', "E %d: %d\n", currPID, pageTableIndex);
+        if (page->dirty && physicalMemoryInfo[frame].file != NULL)
+            writeFilePage(frame);
+        removeMapping(frame, space, pageTableIndex);
+        if (physicalMemoryInfo[frame].space == NULL) {
+            policy->Freed(frame);
+            memoryManager->clearPage(frame);
+        }
+    }
+    if (location >= 0) {
+        swap->Release(location);
+        setSwapLocation(space, pageTableIndex, -1);
+    }
+}
+
+/*
+ * Read pages first .. first+count-1 of the current process, which have
+ * been given frames, into memory.  Runs of pages in consecutive swap
+ * sectors are read with a single request.  The fault on page "first" is
+ * counted according to where it came from.
+ */
+void VirtualMemoryManager::loadPages(int first, int count)
+{
+    AddrSpace* space = currentThread->space;
+    PagingStatistics* paging = &space->getPCB()->paging;
+    char buffer[(MaxReadAhead + 1) * PageSize];
+    int sectors[MaxReadAhead + 1];
+    int i;
+
+    ASSERT(count <= MaxReadAhead + 1);
+
+    // The pages aren't valid yet, but their swap locations have already
+    // moved to their frames' reverse map entries (see setFrameOwner)
+    for (i = 0; i < count; i++)
+        sectors[i] = physicalMemoryInfo[
+            space->getPageTableEntry(first + i)->physicalPage].swapLocation;
+
+    i = 0;
+    while (i < count) {
+        int sector = sectors[i];
+        int run = 1;
+
+        if (sector < 0) {
+            bool fromFile = space->fillPage(first + i, machine->mainMemory +
+                            space->getPageTableEntry(first + i)->physicalPage *
+                            PageSize);
+            if (i == 0 && fromFile)
+                paging->faultsFile++;
+            else if (i == 0)
+                paging->faultsZeroFill++;
+            i++;
+            continue;
+        }
+        while (i + run < count && sectors[i + run] == sector + run * PageSize)
+            run++;
+        swap->Read(buffer, run * PageSize, sector);
+        paging->swapReads++;
+        paging->swapPagesRead += run;
+        if (i == 0)
+            paging->faultsSwap++;
+        for (int j = 0; j < run; j++)
+            bcopy(buffer + j * PageSize, machine->mainMemory +
+                  space->getPageTableEntry(first + i + j)->physicalPage *
+                  PageSize,
+                  PageSize);
+        i += run;
+    }
+
+    for (i = 0; i < count; i++) {
+        TranslationEntry* page = space->getPageTableEntry(first + i);
+
+        // The frame may have held someone else's code; don't let the
+        // simulator run stale predecoded instructions out of it.
+        machine->InvalidateDecoded(page->physicalPage * PageSize, PageSize);
+        page->valid = TRUE;
+        policy->PageIn(page->physicalPage);
+    }
+}
+
+/*
+ * How many of the pages following the faulting page "pageTableIndex"
+ * of the current process to bring in along with it.
+ *
+ * A fault on the page just past what the last fault brought in looks
+ * like a sequential sweep, and doubles the window (up to MaxReadAhead);
+ * any other fault closes it.  We only read ahead into free frames (and
+ * leave the page-out daemon's reserve alone), and
+ * stop at the first page that's already in memory, that isn't part of the
+ * address space, that is a mapped file's, or that could share another
+ * process's frame (copy-on-write, or as program text).
+ */
+int VirtualMemoryManager::readAheadPages(int pageTableIndex)
+{
+    AddrSpace* space = currentThread->space;
+    int count;
 
-  //  int swapSpaceIndex = swapSpaceLoc / PageSize;
- //   SwapSectorInfo * swapPageInfo = swapSpaceInfo + swapSpaceIndex;
-    page->valid = TRUE;
-//printf("set the valid bit\n");
-//    swapPageInfo->setValidBit(TRUE);
-//    swapPageInfo->setPhysMemPageNum(page->physicalPage);
+    if (pageTableIndex == space->nextSequentialFault)
+        space->readAheadWindow = space->readAheadWindow == 0 ? 1 :
+            min(2 * space->readAheadWindow, MaxReadAhead);
+    else
+        space->readAheadWindow = 0;
+
+    for (count = 0; count < space->readAheadWindow &&
+             count < memoryManager->getNumFreePages() - PageOutLow; count++) {
+        int page = pageTableIndex + 1 + count;
+        if (!space->isLegalPage(page) || space->findMapping(page) != NULL ||
+            space->getPageTableEntry(page)->valid)
+            break;
+        int sector = getSwapLocation(space, page);
+        if (sector >= 0 && findFrameHolding(sector) != -1)
+            break;
+        ExecFile* text = textOf(space, page);
+        if (text != NULL && findTextFrame(text, page) != -1)
+            break;
+    }
+    space->nextSequentialFault = pageTableIndex + 1 + count;
+    return count;
 }
 
 /*
@@ -195,13 +1220,45 @@ void VirtualMemoryManager::loadPageToCurrVictim(int virtAddr)
  */
 TranslationEntry* VirtualMemoryManager::getPageTableEntry(FrameInfo * physPageInfo)
 {
-    TranslationEntry* page = physPageInfo->space->getPageTableEntry(physPageInfo->pageTableIndex);
-    return page;
+    return physPageInfo->page;
 }
 
 void VirtualMemoryManager::copySwapSector(int to, int from)
 {
-    char sectorBuf[SectorSize];
-    swapFile->ReadAt(sectorBuf, SWAP_SECTOR_SIZE, from);
-    swapFile->WriteAt(sectorBuf, SWAP_SECTOR_SIZE, to);
+    char sectorBuf[PageSize];
+    swap->Read(sectorBuf, PageSize, from);
+    swap->Write(sectorBuf, PageSize, to);
+}
+
+void VirtualMemoryManager::readFromSwap(char *page, int pageSize,
+                                        int backStoreLoc)
+{
+    swap->Read(page, pageSize, backStoreLoc);
+}
+
+/*
+ * Where the replacement policy's scan of the frames has got to (for the
+ * clock policies), so a checkpoint can carry on from the same place.
+ */
+int VirtualMemoryManager::getNextVictim()
+{
+    return policy->GetHand();
+}
+
+void VirtualMemoryManager::setNextVictim(int victim)
+{
+    policy->SetHand(victim);
+}
+
+/*
+ * Record that physical page "frame" holds virtual page "pageTableIndex"
+ * of "space", and take it out of the free pool; used when restoring a
+ * checkpoint.
+ */
+void VirtualMemoryManager::claimFrame(int frame, AddrSpace* space,
+                                      int pageTableIndex)
+{
+    memoryManager->markPage(frame);
+    setFrameOwner(frame, space, pageTableIndex, NULL);
+    policy->PageIn(frame);
 }
@@ -9,39 +9,139 @@
 #define VIRTUAL_MEMORY_MANAGER_H
 
 #include "bitmap.h"
+#include "synch.h"
+#include "list.h"
+#include "stats.h"
 
 class AddrSpace;
 class TranslationEntry;
+class ReplacementPolicy;
+class SwapManager;
+class ExecFile;
+class SysOpenFile;
+class MemoryMapping;
 
-#define SWAP_SECTORS 512
-#define SWAP_SECTOR_SIZE PageSize
 #define SWAP_FILENAME "SWAP"
+#define MaxReadAhead 8 // most pages brought in after a faulting one
+#define PageOutLow 4   // the page-out daemon starts below this many free frames,
+#define PageOutHigh 8  // and stops at this many
+#define DedupScanTicks 5000 // time between scans for identical pages (-dedup)
 
+/*
+ * The reverse map, which says which pages are mapped to each physical
+ * page, is one array of these: entry N is physical page N's, and the
+ * entries after NumPhysPages are for the other pages sharing a frame
+ * (copy-on-write, as program text, or as a page of a mapped file),
+ * chained together by index.
+ *
+ * The frames holding pages of mapped files are the page cache: a file's
+ * page is in at most one frame, which every process mapping it shares,
+ * writable, and which the Read and Write syscalls go through too (see
+ * readFile and writeFile).  Such a frame is written back to the file,
+ * never to swap, and it is dirty if any of its pages is.
+ */
 struct FrameInfo //This structure is assocated with each physical page
 {
     AddrSpace* space; // Process space currently owrns this particular physical page
     int pageTableIndex; // virtual page number of that process corresponding to this physical page.
+    TranslationEntry* page; // its page table entry
+    int next; // the entry of another page sharing this frame, or -1
+
+    // Only kept in the frame's own entry:
+    int refs; // number of pages mapped to the frame, this one and those on next
+    ExecFile* text; // the program whose text the frame holds, or NULL; the
+                    // frame is shared by every process running it
+    int swapLocation; // where the pages mapped to the frame are in swap
+                      // (they all share it), or -1 if they aren't
+    SysOpenFile* file; // the mapped file the frame holds a page of, or NULL
+    int filePage; // which page of it
 };
 class VirtualMemoryManager
 {
     public:
-        VirtualMemoryManager();
+        VirtualMemoryManager(char *policyName); // see replacement.h
         ~VirtualMemoryManager();
 
-        int allocSwapSector();
+        int allocSwapSlot(AddrSpace* space, int pageTableIndex);
+        int getSwapLocation(AddrSpace* space, int pageTableIndex);
+        void setSwapLocation(AddrSpace* space, int pageTableIndex,
+                             int location);
         void writeToSwap(char *page, int pageSize, int backStoreLoc);
         void swapPageIn(int virtAddr);
+        void copyOnWrite(int virtAddr);
+        void shareAddrSpace(AddrSpace* parent, AddrSpace* child);
+        void addAddrSpace(AddrSpace* space);
         void releasePages(AddrSpace* space);
+        void discardPages(AddrSpace* space, int first, int count);
+        int readFile(SysOpenFile* file, char* into, int size, int position);
+        int writeFile(SysOpenFile* file, char* from, int size, int position);
+        void startPageOutDaemon();
+        void pageOut();
+        void startDedupScanner();
+        void checkDedup();
+        void dedupScan();
+        void Print();
+
+        // paging statistics; each process's are kept in its PCB
+        void sampleResidency();
+        void exportStats(char* fileName);
+
+        // used by the replacement policies (see replacement.h)
+        bool frameInUse(int frame);
+        bool testAndClearUse(int frame);
+        bool frameDirty(int frame);
+        void frameOwner(int frame, AddrSpace** space, int* pageTableIndex);
+        void cleanFrame(int frame);
         void copySwapSector(int to, int from);
+        void readFromSwap(char *page, int pageSize, int backStoreLoc);
+
+        // used to save and restore a checkpoint (see checkpoint.h)
+        int getNextVictim();
+        void setNextVictim(int victim);
+        void claimFrame(int frame, AddrSpace* space, int pageTableIndex);
 
-        void loadPageToCurrVictim(int virtAddr);
+        void loadPages(int first, int count);
         TranslationEntry* getPageTableEntry(FrameInfo * pageInfo);
 
     private:
-        BitMap *swapSectorMap;
-        OpenFile *swapFile;
-        FrameInfo *physicalMemoryInfo;
-        int nextVictim; // current physical page number to be inspected for page replacement
+        int getFreeFrame();
+        void checkFreeFrames();
+        void evictFrame(int frame);
+        void writePageOut(AddrSpace* space, int pageTableIndex);
+        void flushTranslation(AddrSpace* space, int pageTableIndex);
+        void mergeFrames();
+        void mergeFrame(int from, int into);
+        int findFrameHolding(int sector);
+        int findTextFrame(ExecFile* text, int pageTableIndex);
+        ExecFile* textOf(AddrSpace* space, int pageTableIndex);
+        void setFrameOwner(int frame, AddrSpace* space, int pageTableIndex,
+                           ExecFile* text);
+        int readAheadPages(int pageTableIndex);
+        void addMapping(int frame, AddrSpace* space, int pageTableIndex);
+        void removeMapping(int frame, AddrSpace* space, int pageTableIndex);
+        void discardPage(AddrSpace* space, int pageTableIndex);
+        void mapFilePage(AddrSpace* space, int pageTableIndex,
+                         MemoryMapping* mapping);
+        int findFilePage(SysOpenFile* file, int filePage);
+        void writeFilePage(int frame);
+        int newMapping();
+        void freeMapping(int mapping);
+
+        SwapManager *swap; // the swap file; counts the pages stored in each slot
+        FrameInfo *physicalMemoryInfo; // the reverse map (see FrameInfo)
+        int mapSize; // its number of entries
+        int freeMappings; // first of the unused ones, chained by next; or -1
+        ReplacementPolicy *policy; // picks the frames to evict
+        Semaphore *pageOutRequest; // wakes up the page-out daemon
+        bool pageOutPending; // it has been woken up, but hasn't finished yet
+        Semaphore *dedupRequest; // wakes up the dedup scanner; NULL if off
+        bool dedupPending; // it has been woken up, but hasn't finished yet
+        int nextDedupScan; // when to wake it up next
+        int dedupScans, pagesMerged; // what it has done
+        List *spaces; // the address spaces of the processes still running
+        List *exitedStats; // PagingStatistics of the processes that have exited
+        PagingStatistics totals; // resident set samples of all processes
+        int nextResidencySample; // when to take the next ones
 };
 
 #endif